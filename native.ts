@@ -0,0 +1,482 @@
+// typed access to the hand written native apis, the generated services live in ./lib/FlatBufferAPI
+declare function require(id: string): any;
+
+const native = require('./lib/fbrpc_binding.node');
+
+export type Column =
+    Int8Array | Uint8Array | Int16Array | Uint16Array | Int32Array | Uint32Array |
+    BigInt64Array | BigUint64Array | Float32Array | Float64Array;
+
+export interface Columns {
+    [field: string]: Column;
+}
+
+// returned by apis declared with LazyArray<...>, elements are converted on access
+export interface LazyArray<T> extends Iterable<T> {
+    readonly length: number;
+    at(index: number): T | undefined;
+    slice(begin?: number, end?: number): T[];
+}
+
+// std::variant (type = alternative index) and flatbuffers union (type = union tag, NONE gives a null value) values
+export interface Tagged<Type extends number, Value> {
+    type: Type;
+    value: Value;
+}
+
+// wire form of StringTable parameters / results : utf-8 bytes + (length + 1) offsets
+export interface PackedStrings {
+    bytes: Uint8Array;
+    offsets: Uint32Array;
+}
+
+// decodes strings of a packed table on first access only
+export class StringTable implements Iterable<string> {
+    private static decoder = new TextDecoder();
+    private static encoder = new TextEncoder();
+    private cache: (string | undefined)[];
+
+    constructor(private packed: PackedStrings) {
+        this.cache = new Array(this.length);
+    }
+
+    get length(): number {
+        return Math.max(this.packed.offsets.length - 1, 0);
+    }
+
+    get(index: number): string | undefined {
+        if (index < 0 || index >= this.length)
+            return undefined;
+
+        let value = this.cache[index];
+        if (value === undefined) {
+            const { bytes, offsets } = this.packed;
+            value = StringTable.decoder.decode(bytes.subarray(offsets[index], offsets[index + 1]));
+            this.cache[index] = value;
+        }
+        return value;
+    }
+
+    *[Symbol.iterator](): Iterator<string> {
+        for (let i = 0; i < this.length; ++i)
+            yield this.get(i)!;
+    }
+
+    static pack(strings: string[]): PackedStrings {
+        // an utf-16 code unit never takes more than 3 utf-8 bytes
+        let capacity = 0;
+        for (const str of strings)
+            capacity += str.length * 3;
+
+        const bytes = new Uint8Array(capacity);
+        const offsets = new Uint32Array(strings.length + 1);
+        let offset = 0;
+        for (let i = 0; i < strings.length; ++i) {
+            offsets[i] = offset;
+            offset += StringTable.encoder.encodeInto(strings[i], bytes.subarray(offset)).written!;
+        }
+        offsets[strings.length] = offset;
+        return { bytes: bytes.subarray(0, offset), offsets };
+    }
+}
+
+// must match EventRing::Header in src/common/binding/EventRing.h
+const enum RingHeader {
+    WriteIndex,
+    ReadIndex,
+    Capacity,
+    Dropped,
+    LagMax,
+    Waiting,
+    NotifySequence,
+    Frames,
+    Size
+}
+
+const RING_WRAP_MARKER = 0xFFFFFFFF;
+
+// SharedArrayBuffer backed event ring, pass `ring.target` to a native subscribe function in place of the callback
+export class EventRing {
+    readonly target: Int32Array;
+    private bytes: Uint8Array;
+    private view: DataView;
+    private mask: number;
+
+    constructor(readonly capacity: number = 1 << 20) {
+        // 8 bytes at least : a frame header and its payload
+        if (capacity < 8 || (capacity & (capacity - 1)) !== 0)
+            throw new RangeError('event ring capacity should be a power of 2, at least 8');
+
+        const headerBytes = RingHeader.Size * Int32Array.BYTES_PER_ELEMENT;
+        const buffer = new SharedArrayBuffer(headerBytes + capacity);
+        this.target = new Int32Array(buffer);
+        this.target[RingHeader.Capacity] = capacity;
+        this.bytes = new Uint8Array(buffer, headerBytes);
+        this.view = new DataView(buffer, headerBytes);
+        this.mask = capacity - 1;
+    }
+
+    // events dropped because the ring was full
+    get dropped(): number { return Atomics.load(this.target, RingHeader.Dropped); }
+    // highest number of unread bytes seen by the producer
+    get maxLag(): number { return Atomics.load(this.target, RingHeader.LagMax); }
+    get frames(): number { return Atomics.load(this.target, RingHeader.Frames) >>> 0; }
+
+    // hands every pending event to `handler`, a non copied view is only valid during the call
+    poll(handler: (event: Uint8Array) => void, copy: boolean = true): number {
+        let read = Atomics.load(this.target, RingHeader.ReadIndex) >>> 0;
+        const write = Atomics.load(this.target, RingHeader.WriteIndex) >>> 0;
+        let count = 0;
+        while (read !== write) {
+            const offset = read & this.mask;
+            const length = this.view.getUint32(offset, true);
+            if (length === RING_WRAP_MARKER) {
+                read = (read + this.capacity - offset) >>> 0;
+                continue;
+            }
+
+            const begin = offset + 4;
+            handler(copy ? this.bytes.slice(begin, begin + length) : this.bytes.subarray(begin, begin + length));
+            read = (read + 4 + ((length + 3) & ~3)) >>> 0;
+            ++count;
+        }
+        Atomics.store(this.target, RingHeader.ReadIndex, read | 0);
+        return count;
+    }
+
+    // resolves once the ring has pending events, the producer only notifies after we announced we wait
+    async wait(): Promise<void> {
+        const sequence = Atomics.load(this.target, RingHeader.NotifySequence);
+        Atomics.store(this.target, RingHeader.Waiting, 1);
+        if (Atomics.load(this.target, RingHeader.WriteIndex) !== Atomics.load(this.target, RingHeader.ReadIndex)) {
+            Atomics.store(this.target, RingHeader.Waiting, 0);
+            return;
+        }
+
+        const waitAsync = (Atomics as any).waitAsync;
+        if (waitAsync) {
+            const result = waitAsync(this.target, RingHeader.NotifySequence, sequence);
+            if (result.async)
+                await result.value;
+        } else {
+            while (Atomics.load(this.target, RingHeader.NotifySequence) === sequence)
+                await new Promise(resolve => setTimeout(resolve, 1));
+        }
+    }
+
+    // simple consumer loop : wait, drain, repeat
+    async run(handler: (event: Uint8Array) => void, isRunning: () => boolean = () => true): Promise<void> {
+        while (isRunning()) {
+            await this.wait();
+            this.poll(handler);
+        }
+    }
+}
+
+export interface ReflectionAPI {
+    // load a compiled schema (lib/schema/*.bfbs)
+    loadSchema(path: string): void;
+    // same result as `<rootType>.getRootAs...(buffer).unpack()` of the ts object api, decoded natively
+    decode<T = any>(buffer: Uint8Array, rootType: string): T;
+    // vector of structs at `fieldPath` (eg : 'samples' or 'body.samples') => one typed array per scalar field
+    decodeColumns(buffer: Uint8Array, rootType: string, fieldPath: string): Columns;
+    // object api object (or plain object) => flatbuffer, encoded natively
+    encode(value: object, rootType: string): Uint8Array;
+}
+
+export const Reflection: ReflectionAPI = native.Reflection;
+
+export interface PipelineStep {
+    // Service.method of a generated service, eg : 'ExampleAPI.helloWorld'
+    method: string;
+    // request object (needs the service schema, see Reflection.loadSchema), or a request already packed on the
+    // js side (can't be combined with `map`)
+    request?: object | Uint8Array;
+    // request field path <= previous response field path, schema field names, scalars and strings only
+    map?: { [requestField: string]: string };
+    // the chain fails (code 'ERR_RPC_TIMEOUT') when this step isn't answered in time, 30000 by default, 0 waits forever
+    timeoutMs?: number;
+}
+
+export interface PipelineAPI {
+    // runs the whole chain natively, resolves with the last response
+    run(steps: PipelineStep[]): Promise<Uint8Array>;
+}
+
+export const Pipeline: PipelineAPI = native.Pipeline;
+
+export interface CompressionOption {
+    // 'none' turns outbound compression off, inbound compressed payloads are always understood
+    algorithm: 'none' | 'lz4' | 'zstd';
+    // payloads smaller than this (bytes) are sent as is
+    threshold: number;
+    // zstd level or lz4 acceleration, 0 for the library default
+    level: number;
+    // inbound frames expanding past this (bytes) are dropped as corrupted
+    maxSize: number;
+}
+
+export interface CompressionCounters {
+    messages: number;
+    rawBytes: number;
+    compressedBytes: number;
+    ratio: number;
+    cpuMs: number;
+}
+
+export interface CompressionMetrics {
+    compressed: CompressionCounters;
+    decompressed: CompressionCounters;
+    // above the threshold but not smaller once compressed
+    skipped: number;
+    // inbound payloads dropped as corrupted or using an unavailable codec
+    failed: number;
+}
+
+export interface CompressionAPI {
+    // only enable outbound compression for servers known to understand compressed payloads
+    configure(option: CompressionOption): void;
+    metrics(): CompressionMetrics;
+    // wire transforms, eg : for a local stand-in server
+    compress(payload: Uint8Array): Uint8Array;
+    decompress(payload: Uint8Array): Uint8Array;
+}
+
+export const Compression: CompressionAPI = native.Compression;
+
+export interface Endpoint {
+    address: string;
+    port: number;
+}
+
+export interface ShardKey {
+    // Service.method, eg : 'ExampleAPI.helloWorld'
+    method: string;
+    // request field path the shard is picked from, scalars and strings only
+    field: string;
+}
+
+export interface ShardingOption {
+    endpoints: Endpoint[];
+    keys: ShardKey[];
+}
+
+export interface ShardingAPI {
+    // connects every endpoint, resolves once all are connected (or on the first error), needs the schemas loaded
+    connect(option: ShardingOption): Promise<{ result: boolean, message: string }>;
+    // index in `endpoints` a key is routed to
+    shardOf(key: string): number;
+}
+
+export const Sharding: ShardingAPI = native.Sharding;
+
+export interface ReconnectOption {
+    // tried in turn after the endpoint given to connect
+    fallbacks: Endpoint[];
+    // the first retry after a drop goes right away to the next endpoint, later ones wait
+    // initialDelayMs, doubled per attempt up to maxDelayMs, +- jitter (0 <= jitter < 1)
+    initialDelayMs: number;
+    maxDelayMs: number;
+    jitter: number;
+    connectTimeoutMs: number;
+    // calls made while reconnecting fail with code ERR_RPC_DISCONNECTED past this
+    queueTimeoutMs: number;
+    // consecutive failed attempts before giving up, 0 for never
+    maxAttempts: number;
+    // 'Service.method' sent again after a reconnect, other calls in flight fail with code ERR_RPC_DISCONNECTED
+    idempotent: string[];
+}
+
+export interface ReconnectStatus {
+    state: 'idle' | 'connecting' | 'connected';
+    endpoint: string;
+    attempt: number;
+    reconnects: number;
+    replayed: number;
+    failed: number;
+    inflight: number;
+    queued: number;
+}
+
+export interface ReconnectAPI {
+    configure(option: ReconnectOption): void;
+    status(): ReconnectStatus;
+}
+
+export const Reconnect: ReconnectAPI = native.Reconnect;
+
+export interface TransportMetrics {
+    bytesSent: number;
+    messagesSent: number;
+    // responses and events, as received (before decompression)
+    bytesReceived: number;
+    messagesReceived: number;
+    // calls waiting for a connection
+    queued: number;
+    // calls sent and not answered yet
+    inflight: number;
+    // smoothed round trip time, 0 before the first response
+    srttMs: number;
+    reconnects: number;
+    // -1 before anything was received
+    sinceReceiveMs: number;
+}
+
+// counters of the connection behind connect(), one snapshot per call
+export const metrics: () => TransportMetrics = native.metrics;
+
+export const enum CaptureKind {
+    Request = 1,
+    Response = 2,
+    Event = 3
+}
+
+export interface CaptureOption {
+    path: string;
+    // size of the memory mapped log, records beyond it are dropped
+    capacityMB: number;
+}
+
+// requests and responses of the generated service calls and of Pipeline.run, and the events. replay.ts sends
+// the captured requests again through Pipeline.run, every generated service function being an rpc method
+export interface CaptureAPI {
+    start(option: CaptureOption): void;
+    stop(): { records: number, dropped: number, methods: number };
+    // plays a capture back at its original pace divided by `speed` (0 : as fast as possible)
+    replay(path: string, speed: number, callback: (kind: CaptureKind, method: string, payload: Uint8Array) => void): Promise<number>;
+}
+
+export const Capture: CaptureAPI = native.Capture;
+
+export interface LimiterOption {
+    initialLimit: number;
+    minLimit: number;
+    maxLimit: number;
+    // calls waiting for a slot, beyond that calls are rejected with code ERR_RPC_OVERLOADED
+    maxQueue: number;
+    // rtt over `tolerance` x the best rtt seen shrinks the limit
+    tolerance: number;
+}
+
+export interface LimiterStatus {
+    limit: number;
+    inflight: number;
+    queued: number;
+    started: number;
+    rejected: number;
+    minRttMs: number;
+    lastRttMs: number;
+}
+
+export interface LimiterAPI {
+    configure(option: LimiterOption): void;
+    status(): LimiterStatus;
+}
+
+export const Limiter: LimiterAPI = native.Limiter;
+
+export interface Subscription {
+    // releases the native callback (or ring) and drops the events still queued for it
+    unsubscribe(): void;
+    readonly active: boolean;
+}
+
+export interface SubscriptionsAPI {
+    // pass the result to a subscribe* function in place of `target`
+    create(target: Function | Int32Array): Subscription;
+    // keeps only the newest event per `keyField` (a '.' separated path into `rootType`, the schema must be
+    // loaded with Reflection.loadSchema), `callback` receives the events of the keys changed since its last call
+    conflate(callback: (events: Buffer[]) => void, rootType: string, keyField: string): Subscription;
+    // subscriptions not unsubscribed yet
+    count(): number;
+}
+
+export const Subscriptions: SubscriptionsAPI = native.Subscriptions;
+
+export interface CallbackStatistics {
+    // true when the addon was built with FBRPC_COUNT_ALLOCATIONS
+    countAllocations: boolean;
+    // native => js callback calls delivered so far
+    calls: number;
+    // pooled call records created, stays flat once the in flight peak is reached
+    records: number;
+    // native callbacks still holding a thread safe function
+    channels: number;
+    allocations?: number;
+    allocationsPerCall?: number;
+}
+
+// live and peak stay 0 unless the addon is built with FBRPC_COUNT_HANDLES
+export interface HandleStatistics {
+    // estimated handles held by conversions in progress
+    live: number;
+    // highest `live` since the previous call
+    peak: number;
+    // handle scopes opened by conversions so far
+    scopes: number;
+}
+
+export interface StartupStatistics {
+    // time spent in the addon init
+    initMs: number;
+    // exported objects (services, Reflection, ...), created on first access
+    objects: number;
+    // objects accessed so far
+    materialized: number;
+    // functions registered at init
+    deferredFunctions: number;
+    // functions actually created, by the materialized objects
+    createdFunctions: number;
+}
+
+export interface BufferClassStatistics {
+    // slab size of the class in bytes
+    size: number;
+    // slabs held by live js Buffers
+    inUse: number;
+    // slabs waiting for reuse
+    free: number;
+}
+
+export interface BufferStatistics {
+    // bytes held by live js Buffers, also reported to v8 as external memory
+    bytesInUse: number;
+    // bytes of free slabs kept for reuse
+    bytesPooled: number;
+    // v8 external memory total after the last adjustment
+    externalMemory: number;
+    // received payloads served from a free slab
+    hits: number;
+    // received payloads that needed a new slab
+    misses: number;
+    classes: BufferClassStatistics[];
+}
+
+export interface ConflationStatistics {
+    // events received by conflating subscriptions
+    events: number;
+    // events replaced by a newer one of the same key before reaching js
+    conflated: number;
+    delivered: number;
+    // js calls
+    drains: number;
+    // events without a readable key
+    dropped: number;
+}
+
+export interface ResolverStatistics {
+    // native promises not settled yet
+    pending: number;
+    settled: number;
+}
+
+export interface DiagnosticsAPI {
+    callbacks(): CallbackStatistics;
+    handles(): HandleStatistics;
+    startup(): StartupStatistics;
+    buffers(): BufferStatistics;
+    conflation(): ConflationStatistics;
+    resolvers(): ResolverStatistics;
+}
+
+export const Diagnostics: DiagnosticsAPI = native.Diagnostics;
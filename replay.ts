@@ -0,0 +1,58 @@
+import { connect } from './lib/FlatBufferAPI'
+import { Capture, CaptureKind, Pipeline, Diagnostics } from './native'
+
+declare const process: any;
+
+const sleep = async (ms: number): Promise<void> => {
+    return new Promise(resolve => {
+        setTimeout(() => resolve(), ms);
+    })
+}
+
+// usage : node replay.js <capture file> [speed = 1] [address = 127.0.0.1] [port = 8080]
+// replays the requests of a capture against a (stand-in) server, at the captured pace divided by `speed`
+const main = async () => {
+    const [path, speed = '1', address = '127.0.0.1', port = '8080'] = process.argv.slice(2);
+    if (!path) {
+        console.log('usage : node replay.js <capture file> [speed] [address] [port]');
+        return;
+    }
+
+    const { result, message } = await connect({ address, port: Number(port) });
+    if (!result) {
+        console.log('connect failed', message);
+        return;
+    }
+
+    let seen = 0, sent = 0, received = 0, failed = 0;
+    const latencies: number[] = [];
+    const pending: Promise<void>[] = [];
+
+    const start = Date.now();
+    const played = await Capture.replay(path, Number(speed), (kind, method, payload) => {
+        ++seen;
+        if (kind !== CaptureKind.Request)
+            return;
+
+        const sentAt = process.hrtime.bigint();
+        ++sent;
+        pending.push(Pipeline.run([{ method, request: payload }])
+            .then(() => {
+                ++received;
+                latencies.push(Number(process.hrtime.bigint() - sentAt) / 1e6);
+            })
+            .catch(() => { ++failed; }));
+    });
+    // the promise and the record callbacks travel separately, wait for the last records
+    while (seen < played)
+        await sleep(1);
+    await Promise.all(pending);
+
+    latencies.sort((a, b) => a - b);
+    const percentile = (p: number) => latencies.length ? latencies[Math.min(latencies.length - 1, Math.floor(latencies.length * p))].toFixed(3) : '-';
+    console.log(`records ${played}, requests ${sent}, responses ${received}, failed ${failed} in ${Date.now() - start} ms`);
+    console.log(`latency ms p50 ${percentile(0.5)} p99 ${percentile(0.99)} max ${percentile(1)}`);
+    console.log('callbacks', Diagnostics.callbacks());
+}
+
+main()
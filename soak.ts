@@ -0,0 +1,167 @@
+import { connect, ExampleAPI, DelayAddRequestT, EventDataFilterT, HelloWorldRequestT } from './lib/FlatBufferAPI'
+import { Diagnostics, Subscriptions, Subscription } from './native'
+
+declare const process: any;
+declare const global: any;
+
+const sleep = async (ms: number): Promise<void> => {
+    return new Promise(resolve => {
+        setTimeout(() => resolve(), ms);
+    })
+}
+
+interface Sample {
+    minutes: number;
+    rssMB: number;
+    heapMB: number;
+    handles: number;
+    channels: number;
+    pendingResolvers: number;
+    subscriptions: number;
+    p50: number;
+    p99: number;
+}
+
+// growth allowed between the first and the last quarter of the run (after warm up), beyond that the run fails
+const limits = {
+    rssMB: 64,
+    heapMB: 32,
+    handles: 1000,
+    channels: 16,
+    pendingResolvers: 256,
+    subscriptions: 4,
+    // latency ratio
+    p99: 2,
+};
+
+const percentile = (values: number[], p: number) =>
+    values.length ? values[Math.min(values.length - 1, Math.floor(values.length * p))] : 0;
+
+// usage : node [--expose-gc] soak.js [hours = 4] [address = 127.0.0.1] [port = 8080] [sample seconds = 60]
+// drives a mixed workload against a (stand-in) server and fails on memory / handle growth or latency drift.
+// it needs a running ExampleAPI server, which this repository doesn't provide : it is a manual (or nightly, next to
+// such a server) check, it can't run in CI as is. exits 1 when the run fails or is too short to be judged
+const main = async () => {
+    const [hours = '4', address = '127.0.0.1', port = '8080', sampleSeconds = '60'] = process.argv.slice(2);
+    const endAt = Date.now() + Number(hours) * 3600 * 1000;
+
+    const { result, message } = await connect({ address, port: Number(port) });
+    if (!result) {
+        console.log('connect failed', message);
+        process.exit(1);
+    }
+
+    let latencies: number[] = [];
+    let calls = 0, failed = 0, abandoned = 0, events = 0, reconnects = 0;
+
+    const call = async (abandon: boolean) => {
+        const sentAt = process.hrtime.bigint();
+        const request = Math.random() < 0.5
+            ? ExampleAPI.helloWorld(Object.assign(new HelloWorldRequestT(), { name: 'soak' }))
+            : ExampleAPI.delayAdd(Object.assign(new DelayAddRequestT(), { a: calls, b: 1 }));
+        ++calls;
+        try {
+            if (abandon) {
+                // there is no native cancel : the caller gives up, the promise must still settle natively
+                ++abandoned;
+                request.catch(() => { ++failed; });
+                return;
+            }
+            await request;
+            latencies.push(Number(process.hrtime.bigint() - sentAt) / 1e6);
+        } catch {
+            ++failed;
+        }
+    };
+
+    // calls, 10% abandoned
+    const callLoop = async () => {
+        while (Date.now() < endAt) {
+            await Promise.all(Array.from({ length: 32 }, (_, i) => call(i % 10 === 0)));
+            await sleep(5);
+        }
+    };
+
+    // subscriptions living a few seconds each
+    const subscriptionLoop = async () => {
+        while (Date.now() < endAt) {
+            const subscription: Subscription = Subscriptions.create(() => { ++events; });
+            ExampleAPI.subscribeObjectCreateEvent(new EventDataFilterT(42), subscription as any);
+            await sleep(1000 + Math.random() * 4000);
+            subscription.unsubscribe();
+        }
+    };
+
+    // reconnects every few minutes
+    const reconnectLoop = async () => {
+        while (Date.now() < endAt) {
+            await sleep(120 * 1000);
+            if (Date.now() >= endAt)
+                break;
+            const { result } = await connect({ address, port: Number(port) });
+            if (result)
+                ++reconnects;
+        }
+    };
+
+    const samples: Sample[] = [];
+    const start = Date.now();
+    const sampleLoop = async () => {
+        while (Date.now() < endAt) {
+            await sleep(Number(sampleSeconds) * 1000);
+            if (global.gc)
+                global.gc();
+
+            const memory = process.memoryUsage();
+            const window = latencies.sort((a, b) => a - b);
+            latencies = [];
+            const sample: Sample = {
+                minutes: Math.round((Date.now() - start) / 60000),
+                rssMB: memory.rss / 1048576,
+                heapMB: memory.heapUsed / 1048576,
+                // live is back to 0 between conversions, the peak of the window shows a scope leaking handles
+                handles: Diagnostics.handles().peak,
+                channels: Diagnostics.callbacks().channels,
+                pendingResolvers: Diagnostics.resolvers().pending,
+                subscriptions: Subscriptions.count(),
+                p50: percentile(window, 0.5),
+                p99: percentile(window, 0.99),
+            };
+            samples.push(sample);
+            console.log(JSON.stringify({ ...sample, calls, failed, abandoned, events, reconnects }));
+        }
+    };
+
+    await Promise.all([callLoop(), subscriptionLoop(), reconnectLoop(), sampleLoop()]);
+    // lets the abandoned calls settle before the last check
+    await sleep(5000);
+
+    // the first sample is warm up
+    const measured = samples.slice(1);
+    if (measured.length < 4) {
+        console.log(`soak failed : run too short to judge growth (${measured.length} measured samples, 4 needed)`);
+        process.exit(1);
+    }
+    const quarter = Math.floor(measured.length / 4);
+    const average = (list: Sample[], key: keyof Sample) => list.reduce((sum, s) => sum + s[key], 0) / list.length;
+    const first = measured.slice(0, quarter);
+    const last = measured.slice(-quarter);
+
+    const failures: string[] = [];
+    for (const key of ['rssMB', 'heapMB', 'handles', 'channels', 'pendingResolvers', 'subscriptions'] as const) {
+        const growth = average(last, key) - average(first, key);
+        if (growth > limits[key])
+            failures.push(`${key} grew by ${growth.toFixed(1)} (limit ${limits[key]})`);
+    }
+    const drift = average(last, 'p99') / Math.max(average(first, 'p99'), 0.001);
+    if (drift > limits.p99)
+        failures.push(`p99 latency drifted x${drift.toFixed(2)} (limit x${limits.p99})`);
+
+    if (failures.length) {
+        console.log('soak failed :\n  ' + failures.join('\n  '));
+        process.exit(1);
+    }
+    console.log(`soak passed : ${calls} calls, ${failed} failed, ${events} events, ${reconnects} reconnects`);
+}
+
+main()
@@ -1,10 +1,26 @@
 #pragma once
 
+#include <atomic>
+#include <cstring>
+#include <optional>
+#include <exception>
+
 #include <napi.h>
+#include <flatbuffers/flatbuffers.h>
 
 #include "fbrpc/ssFlatBufferRpc.h"
 #include "common/binding/BindingHelper.h"
+#include "common/binding/EventRing.h"
+#include "common/binding/Subscription.h"
+#include "common/binding/BufferPool.h"
 #include "common/node/Node.h"
+#include "rpc/PayloadCodec.h"
+#include "rpc/ConcurrencyLimiter.h"
+#include "rpc/TrafficCapture.h"
+#include "rpc/EventConflator.h"
+#include "rpc/ConnectionManager.h"
+#include "rpc/TransportMetrics.h"
+#include "rpc/ServiceCall.h"
 
 struct Result
 {
@@ -23,6 +39,53 @@ namespace PODTypeBinding
 		);
 	};
 
+	template <>
+	struct Bind<PayloadCodec::Option>
+	{
+		static constexpr auto Binder = makeBinder(
+			"algorithm", &PayloadCodec::Option::algorithm,
+			"threshold", &PayloadCodec::Option::threshold,
+			"level", &PayloadCodec::Option::level,
+			"maxSize", &PayloadCodec::Option::maxSize
+		);
+	};
+
+	template <>
+	struct Bind<ConcurrencyLimiter::Option>
+	{
+		static constexpr auto Binder = makeBinder(
+			"initialLimit", &ConcurrencyLimiter::Option::initialLimit,
+			"minLimit", &ConcurrencyLimiter::Option::minLimit,
+			"maxLimit", &ConcurrencyLimiter::Option::maxLimit,
+			"maxQueue", &ConcurrencyLimiter::Option::maxQueue,
+			"tolerance", &ConcurrencyLimiter::Option::tolerance
+		);
+	};
+
+	template <>
+	struct Bind<TrafficCapture::Option>
+	{
+		static constexpr auto Binder = makeBinder(
+			"path", &TrafficCapture::Option::path,
+			"capacityMB", &TrafficCapture::Option::capacityMB
+		);
+	};
+
+	template <>
+	struct Bind<ConnectionManager::Option>
+	{
+		static constexpr auto Binder = makeBinder(
+			"fallbacks", &ConnectionManager::Option::fallbacks,
+			"initialDelayMs", &ConnectionManager::Option::initialDelayMs,
+			"maxDelayMs", &ConnectionManager::Option::maxDelayMs,
+			"jitter", &ConnectionManager::Option::jitter,
+			"connectTimeoutMs", &ConnectionManager::Option::connectTimeoutMs,
+			"queueTimeoutMs", &ConnectionManager::Option::queueTimeoutMs,
+			"maxAttempts", &ConnectionManager::Option::maxAttempts,
+			"idempotent", &ConnectionManager::Option::idempotent
+		);
+	};
+
 	template <>
 	struct Bind<Result>
 	{
@@ -50,7 +113,9 @@ namespace TypeConversion
 		static fbrpc::sBuffer convert(const Napi::Value& value)
 		{
 			Napi::Buffer buffer = value.As<Napi::Buffer<char>>();
-			return fbrpc::sBuffer::clone(buffer.Data(), buffer.Length());
+			auto result = fbrpc::sBuffer::clone(buffer.Data(), buffer.Length());
+			// the request of a generated service call, packed by its ts wrapper (see ServiceCall)
+			return ServiceCall::packing() ? ServiceCall::pack(std::move(result)) : result;
 		}
 	};
 
@@ -59,38 +124,297 @@ namespace TypeConversion
 	{
 		static Napi::Value convert(const Napi::Env& env, const fbrpc::sBuffer& input)
 		{
-			Napi::Buffer<char> buffer = Napi::Buffer<char>::Copy(env, input.data.get(), input.length);
-			return buffer;
+			// pooled slab, given back when js drops the Buffer (see BufferPool)
+			return BufferPool::instance()->toJs(env, input.data.get(), input.length);
 		}
 	};
 }
 
+//
+// subscription callbacks also accept an EventRing (the Int32Array of EventRing in native.ts) instead of a function,
+// events are then written into the shared ring on the network thread instead of calling into js.
+// both can be wrapped in a Subscription to be unsubscribed later (only here, the generic std::function conversions
+// take plain functions), a conflating one (Subscriptions.conflate)
+// goes through an EventConflator. compressed payloads (see PayloadCodec) are unwrapped here too, so js only
+// ever sees plain flatbuffers
+//
+template <class Arg>
+struct EventCallback
+{
+	static bool check(const Napi::Value& value)
+	{
+		return value.IsFunction() || EventRing::isRing(value) || Subscription::unwrap(value) != nullptr;
+	}
+
+	static std::function<void(Arg)> convert(const Napi::Value& value)
+	{
+		auto subscription = Subscription::unwrap(value);
+		if (subscription && subscription->conflation())
+		{
+			if (!subscription->isActive())
+				throw std::runtime_error("the subscription was unsubscribed");
+
+			auto& conflation = *subscription->conflation();
+			auto conflator = std::make_shared<EventConflator>(subscription->target().As<Napi::Function>(), conflation.rootType, conflation.keyField);
+			subscription->attach([conflator] { conflator->close(); });
+			return [conflator](Arg buffer)
+			{
+				inflate(buffer, [&conflator](const fbrpc::sBuffer& payload)
+					{
+						conflator->push(payload);
+					}
+				);
+			};
+		}
+
+		if ((subscription && subscription->target().IsFunction()) || value.IsFunction())
+		{
+			auto callback = subscription
+				? subscription->bind<void, Arg>()
+				: CallbackWrapper::create<void, Arg>(value.As<Napi::Function>());
+			return [callback](Arg buffer)
+			{
+				inflate(buffer, callback);
+			};
+		}
+
+		if (subscription && !subscription->isActive())
+			throw std::runtime_error("the subscription was unsubscribed");
+
+		auto ring = EventRing::create(subscription ? subscription->target() : value);
+		if (subscription)
+			subscription->attach([ring] { ring->close(); });
+		return [ring](Arg buffer)
+		{
+			inflate(buffer, [&ring](const fbrpc::sBuffer& payload)
+				{
+					ring->write(payload.data.get(), payload.length);
+				}
+			);
+		};
+	}
+
+	template <class Deliver>
+	static void inflate(const fbrpc::sBuffer& buffer, const Deliver& deliver)
+	{
+		TransportMetrics::instance()->received(buffer.length);
+		std::optional<fbrpc::sBuffer> payload;
+		try
+		{
+			payload = PayloadCodec::instance()->decode(buffer);
+		}
+		catch (const std::exception&)
+		{
+			// dropped on the network thread, counted as failed in Compression.metrics()
+			return;
+		}
+		const fbrpc::sBuffer& event = payload ? *payload : buffer;
+		TrafficCapture::instance()->record(TrafficCapture::Kind::kEvent, {}, event);
+		deliver(event);
+	}
+};
+
+template <>
+struct TypeCheck<std::function<void(fbrpc::sBuffer)>> : EventCallback<fbrpc::sBuffer> {};
+
+template <>
+struct TypeCheck<std::function<void(const fbrpc::sBuffer&)>> : EventCallback<const fbrpc::sBuffer&> {};
+
+namespace TypeConversion
+{
+	template <>
+	struct JsToCpp<std::function<void(fbrpc::sBuffer)>> : EventCallback<fbrpc::sBuffer> {};
+
+	template <>
+	struct JsToCpp<std::function<void(const fbrpc::sBuffer&)>> : EventCallback<const fbrpc::sBuffer&> {};
+}
+
+//
+// request table encoded natively : the js object is converted to its object api type T (eg : HelloWorldRequestT,
+// described by the PODTypeBinding::Bind<T> fbrpc_generator emits per table) and packed by a FlatBufferBuilder whose
+// memory becomes the request, so neither the js Builder nor an intermediate Buffer is created. a Buffer packed on the
+// js side is still accepted. the journal, compression and capture don't depend on it (see ServiceCall::pack)
+//
 template <class T>
-class Resolver : public Napi::AsyncWorker 
+struct Packed
+{
+	fbrpc::sBuffer buffer;
+};
+
+// builder memory an sBuffer can take over : allocated like the one of sBuffer::clone
+class PackedAllocator : public flatbuffers::Allocator
+{
+public:
+	uint8_t* allocate(size_t size) override
+	{
+		return reinterpret_cast<uint8_t*>(new char[size]);
+	}
+
+	void deallocate(uint8_t* p, size_t) override
+	{
+		delete[] reinterpret_cast<char*>(p);
+	}
+};
+
+template <class T>
+struct TypeCheck<Packed<T>>
+{
+	static bool check(const Napi::Value& value)
+	{
+		return value.IsBuffer() || TypeCheck<T>::check(value);
+	}
+};
+
+namespace TypeConversion
+{
+	template <class T>
+	struct JsToCpp<Packed<T>>
+	{
+		static Packed<T> convert(const Napi::Value& value)
+		{
+			if (value.IsBuffer())
+				return { JsToCpp<fbrpc::sBuffer>::convert(value) };
+
+			// sized as the previous request of the type, the builder seldom grows
+			static size_t reserved = 1024;
+			static PackedAllocator allocator;
+			flatbuffers::FlatBufferBuilder builder(reserved, &allocator);
+
+			T native = JsToCpp<T>::convert(value);
+			builder.Finish(T::TableType::Pack(builder, &native));
+
+			// the table is built at the end of the builder's memory, moved to its start it is owned as is
+			size_t length = builder.GetSize();
+			size_t size = 0, offset = 0;
+			auto data = builder.ReleaseRaw(size, offset);
+			std::memmove(data, data + offset, length);
+			reserved = size;
+
+			fbrpc::sBuffer buffer;
+			buffer.data.reset(reinterpret_cast<char*>(data));
+			buffer.length = length;
+			return { ServiceCall::pack(std::move(buffer)) };
+		}
+	};
+}
+
+// promises created by the bindings and not settled yet, a soak run (see soak.ts) fails when they keep growing
+struct ResolverStats
+{
+	inline static uint64_t created = 0;
+	inline static uint64_t settled = 0;
+
+	static Napi::Value report()
+	{
+		auto result = Napi::Object::New(Node::getEnv());
+		result.Set("pending", static_cast<double>(created - settled));
+		result.Set("settled", static_cast<double>(settled));
+		return result;
+	}
+};
+
+//
+// settles a promise from any thread : the first call() / fail() queues the async work settling it on the js thread,
+// later ones are ignored. the work deletes itself once done, so the Resolver (usually owned by response callbacks
+// released on a network thread) may go away while it is queued. a Resolver dropped unsettled rejects its promise,
+// unless it is dropped by an exception on the js thread : the promise was then never handed out
+//
+template <class T>
+class Resolver
 {
 public:
 	Resolver(Napi::Promise::Deferred promise)
-		: Napi::AsyncWorker(promise.Env()), m_promise(promise)
+		: m_worker(new Worker(promise)), m_exceptions(std::uncaught_exceptions())
+	{}
+
+	Resolver(const Resolver&) = delete;
+	Resolver& operator=(const Resolver&) = delete;
+
+	~Resolver()
 	{
-		SuppressDestruct();
+		auto worker = m_worker.exchange(nullptr);
+		if (!worker)
+			return;
+
+		if (std::uncaught_exceptions() > m_exceptions && Node::isJsThread())
+		{
+			--ResolverStats::created;
+			delete worker;
+		}
+		else
+		{
+			worker->reject("the call ended without a result", nullptr);
+		}
 	}
 
 	void call(T&& arg)
 	{
-		m_arg = std::forward<T>(arg);
-		Queue();
+		if (auto worker = m_worker.exchange(nullptr))
+			worker->resolve(std::forward<T>(arg));
 	}
 
-	void Execute() override {}
-	void OnOK() override
+	// `code` is set on the rejected Error, see CodedError
+	void fail(std::string message, const char* code = nullptr)
 	{
-		m_promise.Resolve(TypeConversion::CppToJs<T>::convert(m_promise.Env(), m_arg));
+		if (auto worker = m_worker.exchange(nullptr))
+			worker->reject(std::move(message), code);
 	}
+
 private:
-	Napi::Promise::Deferred m_promise;
-	std::decay_t<T> m_arg;
+	class Worker : public Napi::AsyncWorker
+	{
+	public:
+		Worker(Napi::Promise::Deferred promise)
+			: Napi::AsyncWorker(promise.Env()), m_promise(promise)
+		{
+			++ResolverStats::created;
+		}
+
+		void resolve(T&& arg)
+		{
+			m_arg.emplace(std::forward<T>(arg));
+			Queue();
+		}
+
+		void reject(std::string message, const char* code)
+		{
+			m_error = std::move(message);
+			m_code = code;
+			Queue();
+		}
+
+		void Execute() override
+		{
+			if (!m_error.empty())
+				SetError(m_error);
+		}
+		void OnOK() override
+		{
+			++ResolverStats::settled;
+			m_promise.Resolve(TypeConversion::CppToJs<T>::convert(m_promise.Env(), *m_arg));
+		}
+		void OnError(const Napi::Error& error) override
+		{
+			++ResolverStats::settled;
+			auto value = error.Value();
+			if (m_code)
+				value.Set("code", Napi::String::New(m_promise.Env(), m_code));
+			m_promise.Reject(value);
+		}
+
+	private:
+		Napi::Promise::Deferred m_promise;
+		std::optional<std::decay_t<T>> m_arg;
+		std::string m_error;
+		const char* m_code = nullptr;
+	};
+
+	// queued once, then owned by the async work
+	std::atomic<Worker*> m_worker;
+	int m_exceptions;
 };
 
+// the connection is kept up by ConnectionManager (see Reconnect.configure), the promise settles with the first attempt
 class FlatbufferClient
 {
 public:
@@ -99,35 +423,24 @@ public:
 		auto promise = Napi::Promise::Deferred::New(Node::getEnv());
 		auto resolver = std::make_shared<Resolver<Result>>(promise);
 
-		if (!m_client)
-		{
-			m_client = fbrpc::sFlatBufferRpcClient::create(std::move(option));
-
-			m_client->on<fbrpc::sError>([resolver](const fbrpc::sError& e)
-				{
-					resolver->call(Result{ false, e.msg });
-				}
-			);
-
-			m_client->on<fbrpc::sConnectionEvent>([resolver](const fbrpc::sConnectionEvent& e)
-				{
-					resolver->call(Result{ true });
-				}
-			);
-		}
-
-		m_client->connect();
+		ConnectionManager::instance()->connect(std::move(option), [resolver](bool connected, const std::string& message)
+			{
+				resolver->call(Result{ connected, message });
+			}
+		);
 		return promise.Promise();
 	}
 
+	// the client a generated binding sends on, kept alive by the call running it (see ServiceCall).
+	// outside of a binding, the connected one
 	static fbrpc::sFlatBufferRpcClient* get() 
 	{
-		if (!m_client || !m_client->isConnected())
-			throw std::runtime_error("client is not connected");
-
-		return m_client.get(); 
+		auto client = ServiceCall::client();
+		return client ? client.get() : ConnectionManager::instance()->client().get();
 	}
 
-private:
-	inline static std::unique_ptr<fbrpc::sFlatBufferRpcClient> m_client = nullptr;
+	static Napi::Value metrics()
+	{
+		return TransportMetrics::snapshot();
+	}
 };
\ No newline at end of file
@@ -1,22 +1,137 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+
 #include <napi.h>
 
 #include "PODTypeBinding.h"
 #include "CppStaticBinding.h"
 #include "CppClassBinding.h"
+#include "CppClassWrap.h"
+#include "LazyArray.h"
+#include "StringTable.h"
+#include "common/node/Node.h"
+
+//
+// objects opened with begin() (eg : one per generated service) are lazy : exports only gets an accessor, the
+// object and its functions are created on first access and then replace the accessor, so addon load does not
+// grow with the number of services. Diagnostics.startup() reports what was deferred and what got used
+//
+struct LazyBindingStats
+{
+    double initMs = 0;
+    uint32_t objects = 0;
+    uint32_t materialized = 0;
+    uint32_t deferredFunctions = 0;
+    uint32_t createdFunctions = 0;
+
+    static LazyBindingStats& get()
+    {
+        static LazyBindingStats stats;
+        return stats;
+    }
+
+    static Napi::Value report()
+    {
+        auto& stats = get();
+        auto result = Napi::Object::New(Node::getEnv());
+        result.Set("initMs", stats.initMs);
+        result.Set("objects", stats.objects);
+        result.Set("materialized", stats.materialized);
+        result.Set("deferredFunctions", stats.deferredFunctions);
+        result.Set("createdFunctions", stats.createdFunctions);
+        return result;
+    }
+};
+
+class LazyObject
+{
+public:
+    using Member = std::function<void(Napi::Env, Napi::Object&)>;
+
+    LazyObject(std::string name) : m_name(std::move(name)) {}
+
+    const std::string& name() const
+    {
+        return m_name;
+    }
+
+    void add(Member member)
+    {
+        m_members.push_back(std::move(member));
+        ++LazyBindingStats::get().deferredFunctions;
+    }
+
+    static Napi::Value get(const Napi::CallbackInfo& info)
+    {
+        auto self = static_cast<LazyObject*>(info.Data());
+        if (self->m_object.IsEmpty())
+        {
+            Napi::Env env = info.Env();
+            auto object = Napi::Object::New(env);
+            for (auto& member : self->m_members)
+                member(env, object);
+
+            LazyBindingStats::get().createdFunctions += static_cast<uint32_t>(self->m_members.size());
+            ++LazyBindingStats::get().materialized;
+            self->m_members.clear();
+            self->m_object = Napi::Persistent(object);
+            self->m_object.SuppressDestruct();
+
+            // later reads skip the accessor. writable like the eagerly bound objects were, so js can still patch them
+            if (info.This().IsObject())
+                info.This().As<Napi::Object>().DefineProperty(
+                    Napi::PropertyDescriptor::Value(self->m_name, object, static_cast<napi_property_attributes>(napi_writable | napi_enumerable | napi_configurable)));
+        }
+        return self->m_object.Value();
+    }
+
+    // assigned before its first read : the value replaces the accessor as is, the object is never created
+    static void set(const Napi::CallbackInfo& info)
+    {
+        auto self = static_cast<LazyObject*>(info.Data());
+        if (info.This().IsObject())
+            info.This().As<Napi::Object>().DefineProperty(
+                Napi::PropertyDescriptor::Value(self->m_name, info[0], static_cast<napi_property_attributes>(napi_writable | napi_enumerable | napi_configurable)));
+    }
+
+private:
+    std::string m_name;
+    std::vector<Member> m_members;
+    Napi::ObjectReference m_object;
+};
 
 template <class T>
 class BindingHelperBase
 {
 public:
+    using Callback = Napi::Value (*)(const Napi::CallbackInfo&);
+    using Callable = std::function<Napi::Value(const Napi::CallbackInfo&)>;
+    // given "Object.function" and its binding when the function is added, returns what js calls instead
+    using Interceptor = Callable (*)(const std::string& name, Callback callback);
+
     BindingHelperBase(Napi::Env env, Napi::Object& exports)
         : m_env(env), m_exports(exports) {}
 
+    // the functions added to objects until intercept(nullptr) go through `interceptor`
+    // (eg : ServiceCall::bind for the generated services)
+    T& intercept(Interceptor interceptor)
+    {
+        m_interceptor = interceptor;
+        return self();
+    }
+
     T& begin(const char* className)
     {
-        m_currentObj = Napi::Object::New(m_env);
-        m_exports.Set(className, m_currentObj);
+        // lives as long as the addon, the accessor keeps a raw pointer to it
+        m_lazyObjects.push_back(std::make_unique<LazyObject>(className));
+        m_currentObj = m_lazyObjects.back().get();
+        m_exports.DefineProperty(Napi::PropertyDescriptor::Accessor(m_env, m_exports, className, &LazyObject::get, &LazyObject::set,
+            static_cast<napi_property_attributes>(napi_enumerable | napi_configurable), m_currentObj));
+        ++LazyBindingStats::get().objects;
         return self();
     }
 
@@ -24,13 +139,20 @@ public:
     T& addStaticFunction(const char* funcName)
     {
         constexpr auto wrapperCall = T::template Wrapper<F>::call;
-        m_currentObj.Set(funcName, Napi::Function::New(m_env, CppStaticBinding<wrapperCall>::call));
-        return self();
+        return addFunction<CppStaticBinding<wrapperCall>::call>(funcName);
+    }
+
+    // same as addStaticFunction without argument checks, see CppBinding::CheckPolicy
+    template<auto F>
+    T& addTrustedFunction(const char* funcName)
+    {
+        constexpr auto wrapperCall = T::template Wrapper<F>::call;
+        return addFunction<CppStaticBinding<wrapperCall, CppBinding::CheckPolicy::kTrusted>::call>(funcName);
     }
 
     T& end()
     {
-        m_currentObj = Napi::Object();
+        m_currentObj = nullptr;
         return self();
     }
 
@@ -41,16 +163,50 @@ public:
         return self();
     }
 
+    //
+    // exports C as a js class, `new className(...CtorArgs)` :
+    //   helper.beginClass<Counter, int>("Counter").addMethod<&Counter::add>("add").endClass();
+    //
+    template<class C, class ... CtorArgs>
+    CppClassBuilder<T, C, CtorArgs...> beginClass(const char* className)
+    {
+        return CppClassBuilder<T, C, CtorArgs...>(self(), m_env, m_exports, className);
+    }
+
 private:
     T& self()
     {
         return static_cast<T&>(*this);
     }
 
+    template<Napi::Value (*Call)(const Napi::CallbackInfo&)>
+    T& addFunction(const char* funcName)
+    {
+        if (m_interceptor)
+        {
+            auto callable = m_interceptor(m_currentObj->name() + "." + funcName, Call);
+            m_currentObj->add([name = std::string(funcName), callable](Napi::Env env, Napi::Object& object)
+                {
+                    object.Set(name, Napi::Function::New(env, callable, name));
+                }
+            );
+            return self();
+        }
+
+        m_currentObj->add([name = std::string(funcName)](Napi::Env env, Napi::Object& object)
+            {
+                object.Set(name, Napi::Function::New(env, Call, name));
+            }
+        );
+        return self();
+    }
+
 private:
     Napi::Env m_env;
     Napi::Object& m_exports;
-    Napi::Object m_currentObj;
+    LazyObject* m_currentObj = nullptr;
+    Interceptor m_interceptor = nullptr;
+    inline static std::vector<std::unique_ptr<LazyObject>> m_lazyObjects;
 };
 
 class BindingHelper : public BindingHelperBase<BindingHelper>
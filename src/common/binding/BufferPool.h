@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#include <napi.h>
+
+#include "common/node/Node.h"
+#include "common/utils/Singleton.h"
+
+//
+// size classed slabs for received payloads : a response is copied into a pooled slab and handed to js as an
+// external Buffer, whose finalizer gives the slab back once js dropped it. every live slab is reported to v8
+// through napi_adjust_external_memory, so the GC sees the native memory held by those Buffers and runs in time.
+// payloads above the largest class get a slab of their own, accounted the same way but never kept
+//
+class BufferPool : public Singleton<BufferPool>
+{
+public:
+    static constexpr size_t kMinSlab = 256;
+    static constexpr size_t kClasses = 13; // 256 B to 1 MiB
+    static constexpr size_t kMaxSlab = kMinSlab << (kClasses - 1);
+    static constexpr size_t kMaxPooledBytes = 4 * 1024 * 1024; // free slabs kept per class
+
+    // js thread only, as the Buffer finalizer
+    Napi::Buffer<char> toJs(const Napi::Env& env, const char* data, size_t length)
+    {
+        size_t capacity = 0;
+        char* slab = acquire(length, capacity);
+        std::memcpy(slab, data, length);
+
+        Napi::Buffer<char> buffer;
+        try
+        {
+            buffer = Napi::Buffer<char>::New(env, slab, length, &BufferPool::finalize, reinterpret_cast<void*>(capacity));
+        }
+        catch (const Napi::Error&)
+        {
+            // runtimes without external buffers (eg : v8 sandbox) get a plain copy
+            release(slab, capacity);
+            return Napi::Buffer<char>::Copy(env, data, length);
+        }
+
+        int64_t adjusted = 0;
+        napi_adjust_external_memory(env, static_cast<int64_t>(capacity), &adjusted);
+        m_external = adjusted;
+        return buffer;
+    }
+
+    static Napi::Value report()
+    {
+        auto pool = instance();
+        std::lock_guard<std::mutex> lock(pool->m_mutex);
+
+        Napi::Env env = Node::getEnv();
+        auto classes = Napi::Array::New(env, kClasses);
+        for (uint32_t i = 0; i < kClasses; ++i)
+        {
+            auto& sizeClass = pool->m_classes[i];
+            auto entry = Napi::Object::New(env);
+            entry.Set("size", static_cast<double>(kMinSlab << i));
+            entry.Set("inUse", static_cast<double>(sizeClass.inUse));
+            entry.Set("free", static_cast<double>(sizeClass.free.size()));
+            classes[i] = entry;
+        }
+
+        auto result = Napi::Object::New(env);
+        result.Set("bytesInUse", static_cast<double>(pool->m_bytesInUse));
+        result.Set("bytesPooled", static_cast<double>(pool->m_bytesPooled));
+        result.Set("externalMemory", static_cast<double>(pool->m_external));
+        result.Set("hits", static_cast<double>(pool->m_hits));
+        result.Set("misses", static_cast<double>(pool->m_misses));
+        result.Set("classes", classes);
+        return result;
+    }
+
+private:
+    struct SizeClass
+    {
+        std::vector<char*> free;
+        size_t inUse = 0;
+    };
+
+    static size_t classOf(size_t length)
+    {
+        size_t index = 0;
+        while ((kMinSlab << index) < length)
+            ++index;
+        return index;
+    }
+
+    char* acquire(size_t length, size_t& capacity)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (length > kMaxSlab)
+        {
+            capacity = length;
+            ++m_misses;
+            m_bytesInUse += capacity;
+            return new char[capacity];
+        }
+
+        size_t index = classOf(length);
+        auto& sizeClass = m_classes[index];
+        capacity = kMinSlab << index;
+        ++sizeClass.inUse;
+        m_bytesInUse += capacity;
+        if (sizeClass.free.empty())
+        {
+            ++m_misses;
+            return new char[capacity];
+        }
+
+        ++m_hits;
+        char* slab = sizeClass.free.back();
+        sizeClass.free.pop_back();
+        m_bytesPooled -= capacity;
+        return slab;
+    }
+
+    void release(char* slab, size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bytesInUse -= capacity;
+        if (capacity > kMaxSlab)
+        {
+            delete[] slab;
+            return;
+        }
+
+        auto& sizeClass = m_classes[classOf(capacity)];
+        --sizeClass.inUse;
+        if ((sizeClass.free.size() + 1) * capacity > kMaxPooledBytes)
+        {
+            delete[] slab;
+            return;
+        }
+        sizeClass.free.push_back(slab);
+        m_bytesPooled += capacity;
+    }
+
+    static void finalize(Napi::Env env, char* slab, void* hint)
+    {
+        auto capacity = reinterpret_cast<size_t>(hint);
+        auto pool = instance();
+        pool->release(slab, capacity);
+
+        int64_t adjusted = 0;
+        napi_adjust_external_memory(env, -static_cast<int64_t>(capacity), &adjusted);
+        pool->m_external = adjusted;
+    }
+
+    std::mutex m_mutex;
+    std::array<SizeClass, kClasses> m_classes;
+    size_t m_bytesInUse = 0;
+    size_t m_bytesPooled = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    int64_t m_external = 0; // v8's total external memory after our last adjustment
+};
@@ -6,6 +6,8 @@
 #include <cstdint>
 #include <vector>
 #include <atomic>
+#include <mutex>
+#include <memory>
 #include <thread>
 #include <unordered_set>
 #include <cassert>
@@ -13,7 +15,10 @@
 #include <windows.h>
 #include <napi.h>
 
+#include "common/node/Node.h"
 #include "common/utils/Singleton.h"
+#include "common/utils/AllocationCounter.h"
+#include "common/utils/UseGuard.h"
 
 class ThreadSafeFunctionWrapper
 {
@@ -24,39 +29,209 @@ public:
     Napi::ThreadSafeFunction func;
 };
 
+// allocations are only counted when built with FBRPC_COUNT_ALLOCATIONS, calls and records always are
+struct CallbackStats : public Singleton<CallbackStats>
+{
+    std::atomic<uint64_t> calls{ 0 };
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> records{ 0 };
+    std::atomic<int64_t> channels{ 0 }; // live thread safe functions
+};
+
+// the native side of one js callback, closing it stops queuing calls and drops the queued ones
+class CallbackChannel
+{
+public:
+    virtual ~CallbackChannel() = default;
+    virtual void close() = 0;
+};
+
+//
+// fixed size call records of one callback, a record is taken by the calling thread and given back by the
+// js thread once the call is done, the pool only grows while more calls are in flight than ever before
+//
+template <class Tuple>
+class CallRecordPool
+{
+public:
+    static constexpr size_t kInitialRecords = 16;
+
+    struct Record
+    {
+        std::optional<Tuple> args;
+        Record* next = nullptr;
+    };
+
+    // set once the channel is closed, queued records are then released without calling js
+    std::atomic<bool> closed{ false };
+
+    CallRecordPool()
+    {
+        m_records.reserve(kInitialRecords);
+        for (size_t i = 0; i < kInitialRecords; ++i)
+            release(grow());
+    }
+
+    Record* acquire()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_free)
+            {
+                auto record = m_free;
+                m_free = record->next;
+                return record;
+            }
+        }
+        return grow();
+    }
+
+    void release(Record* record)
+    {
+        record->args.reset();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        record->next = m_free;
+        m_free = record;
+    }
+
+private:
+    Record* grow()
+    {
+        auto record = std::make_unique<Record>();
+        auto recordPtr = record.get();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_records.push_back(std::move(record));
+        CallbackStats::instance()->records.fetch_add(1, std::memory_order_relaxed);
+        return recordPtr;
+    }
+
+    std::mutex m_mutex;
+    Record* m_free = nullptr;
+    std::vector<std::unique_ptr<Record>> m_records;
+};
+
 class CallbackWrapper
 {
 public:
+    // `channel` optionally receives the channel, to close it before the function is destroyed
     template <class Ret, class ... Args>
-    static std::function<Ret(Args...)> create(const Napi::Function& callback)
+    static std::function<Ret(Args...)> create(const Napi::Function& callback, std::shared_ptr<CallbackChannel>* channelOut = nullptr)
     {
-        auto threadSafeFunction = Napi::ThreadSafeFunction::New(callback.Env(), callback, "ElectronSafeCallback", 0, 1);
-        auto threadSafeFunctionPtr = std::make_shared<ThreadSafeFunctionWrapper>(threadSafeFunction);
-
-        return [threadSafeFunctionPtr](Args&& ... args)
+        auto channel = std::make_shared<Channel<Args...>>(callback);
+        if (channelOut)
+            *channelOut = channel;
+        return [channel](Args&& ... args)
         {
-            auto tuple = std::make_tuple(std::forward<Args>(args)...);
-            using TupleType = decltype(tuple);
-            std::shared_ptr<TupleType> tuplePtr(std::tuple_size_v<TupleType> == 0 ? nullptr : new TupleType(std::move(tuple)));
-            (*threadSafeFunctionPtr)->BlockingCall(
-                [tuplePtr](Napi::Env env, Napi::Function jsCallback)
-                {
-                    try
-                    {
-                        jsCallback.Call(tuplePtr ? tupleToArgs(env, *tuplePtr, std::make_index_sequence<sizeof...(Args)>{}) : std::vector<napi_value>{});
-                    }
-                    catch (const Napi::Error& error)
-                    {
-                        error.ThrowAsJavaScriptException();
-                    }
-                }
-            );
+            channel->call(std::forward<Args>(args)...);
         };
     }
 
-    template <class Tuple, std::size_t ... Index>
-    static std::vector<napi_value> tupleToArgs(const Napi::Env& env, Tuple&& tuple, std::index_sequence<Index...>)
+    static Napi::Value statistics()
     {
-        return { TypeConversion::CppToJs<std::tuple_element_t<Index, std::decay_t<Tuple>>>::convert(env, std::get<Index>(std::forward<Tuple>(tuple)))... };
+        Napi::Env env = Node::getEnv();
+        auto stats = CallbackStats::instance();
+        auto calls = stats->calls.load();
+        auto allocations = stats->allocations.load();
+
+        auto result = Napi::Object::New(env);
+        result.Set("countAllocations", AllocationCounter::enabled);
+        result.Set("calls", static_cast<double>(calls));
+        result.Set("records", static_cast<double>(stats->records.load()));
+        result.Set("channels", static_cast<double>(stats->channels.load()));
+        if (AllocationCounter::enabled)
+        {
+            result.Set("allocations", static_cast<double>(allocations));
+            result.Set("allocationsPerCall", calls ? static_cast<double>(allocations) / calls : 0.0);
+        }
+        return result;
     }
-};
\ No newline at end of file
+
+private:
+    //
+    // a thread safe function carrying pooled records, so an event costs no allocation of its own : the arguments
+    // are moved into a recycled record, queued as is and converted into a napi_value array on the js stack
+    //
+    template <class ... Args>
+    class Channel : public CallbackChannel
+    {
+    public:
+        using Tuple = std::tuple<std::decay_t<Args>...>;
+        using Pool = CallRecordPool<Tuple>;
+        using Record = typename Pool::Record;
+
+        Channel(const Napi::Function& callback)
+        {
+            // the pool belongs to the thread safe function, queued records stay valid until it is finalized
+            m_function = Function::New(callback.Env(), callback, "ElectronSafeCallback", 0, 1, new Pool(),
+                [](Napi::Env, Pool* pool) { delete pool; });
+            CallbackStats::instance()->channels.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        ~Channel()
+        {
+            close();
+        }
+
+        void close() override
+        {
+            if (!m_guard.close())
+                return;
+
+            m_function.GetContext()->closed = true;
+            m_function.Release();
+            CallbackStats::instance()->channels.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        template <class ... CallArgs>
+        void call(CallArgs&& ... args)
+        {
+            std::optional<AllocationCounter::Scope> scope;
+            if constexpr (AllocationCounter::enabled)
+                scope.emplace(CallbackStats::instance()->allocations);
+
+            if (!m_guard.enter())
+                return;
+
+            auto pool = m_function.GetContext();
+            auto record = pool->acquire();
+            record->args.emplace(std::forward<CallArgs>(args)...);
+            if (m_function.BlockingCall(record) != napi_ok)
+                pool->release(record);
+            m_guard.leave();
+        }
+
+    private:
+        static void callJs(Napi::Env env, Napi::Function jsCallback, Pool* pool, Record* record)
+        {
+            if (env != nullptr && !jsCallback.IsEmpty() && !pool->closed)
+            {
+                std::optional<AllocationCounter::Scope> scope;
+                if constexpr (AllocationCounter::enabled)
+                    scope.emplace(CallbackStats::instance()->allocations);
+
+                try
+                {
+                    invoke(env, jsCallback, *record->args, std::make_index_sequence<sizeof...(Args)>{});
+                }
+                catch (const Napi::Error& error)
+                {
+                    error.ThrowAsJavaScriptException();
+                }
+                CallbackStats::instance()->calls.fetch_add(1, std::memory_order_relaxed);
+            }
+            pool->release(record);
+        }
+
+        template <std::size_t ... Index>
+        static void invoke(const Napi::Env& env, const Napi::Function& jsCallback, Tuple& args, std::index_sequence<Index...>)
+        {
+            // one extra slot so calls without arguments still declare a valid array
+            napi_value argv[sizeof...(Index) + 1] = { TypeConversion::CppToJs<std::tuple_element_t<Index, Tuple>>::convert(env, std::get<Index>(args))... };
+            jsCallback.Call(sizeof...(Index), argv);
+        }
+
+        using Function = Napi::TypedThreadSafeFunction<Pool, Record, callJs>;
+        Function m_function;
+        UseGuard m_guard;
+    };
+};
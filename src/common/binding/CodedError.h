@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+
+//
+// runtime_error carrying a stable `code` (eg : ERR_RPC_OVERLOADED), set on the js Error by the bindings
+// so callers can tell failures apart without parsing messages
+//
+class CodedError : public std::runtime_error
+{
+public:
+    CodedError(const char* code, const std::string& message) : std::runtime_error(message), m_code(code) {}
+
+    const char* code() const
+    {
+        return m_code;
+    }
+
+private:
+    const char* m_code;
+};
@@ -9,6 +9,22 @@
 
 namespace CppBinding
 {
+    //
+    // kTrusted bindings skip the TypeCheck pass, for entry points only reached through the generated, already
+    // type checked typescript wrappers. building with FBRPC_CHECK_TRUSTED_BINDINGS checks them again everywhere
+    //
+    enum class CheckPolicy
+    {
+        kChecked,
+        kTrusted
+    };
+
+#ifdef FBRPC_CHECK_TRUSTED_BINDINGS
+    constexpr bool CheckTrustedBindings = true;
+#else
+    constexpr bool CheckTrustedBindings = false;
+#endif
+
     template<class ...Args>
     static void checkArgCountAndType(const Napi::CallbackInfo& info)
     {
@@ -20,6 +36,13 @@ namespace CppBinding
         checkInput<GetDecayType<std::decay_t<Args>>...>(info, std::make_index_sequence<parameterCount>{});
     }
 
+    template<CheckPolicy Policy, class ...Args>
+    static void checkArgs(const Napi::CallbackInfo& info)
+    {
+        if constexpr (Policy == CheckPolicy::kChecked || CheckTrustedBindings)
+            checkArgCountAndType<Args...>(info);
+    }
+
     template<class ... Args, std::size_t ... Index>
     static void checkInput(const Napi::CallbackInfo& info, std::index_sequence<Index...>)
     {
@@ -14,8 +14,9 @@
 #include "TypeDecay.h"
 #include "CallbackWrapper.h"
 #include "CppBinding.h"
+#include "CodedError.h"
 
-template<auto F, class C, class R, class ...Args>
+template<auto F, CppBinding::CheckPolicy Policy, class C, class R, class ...Args>
 struct CppClassBindingImpl
 {
     static Napi::Value call(C* instance, const Napi::CallbackInfo& info)
@@ -27,7 +28,7 @@ struct CppClassBindingImpl
             constexpr auto parameterCount = sizeof...(Args);
             if constexpr (parameterCount > 0)
             {
-                CppBinding::checkArgCountAndType<Args...>(info);
+                CppBinding::checkArgs<Policy, Args...>(info);
                 return CppBinding::invoke<C, F, R, Args...>(instance, info);
             }
             else
@@ -44,6 +45,12 @@ struct CppClassBindingImpl
                 }
             }
         }
+        catch (const CodedError& err)
+        {
+            auto error = Napi::Error::New(info.Env(), err.what());
+            error.Set("code", Napi::String::New(info.Env(), err.code()));
+            throw error;
+        }
         catch (std::runtime_error& err)
         {
             throw Napi::Error::New(info.Env(), err.what());
@@ -52,23 +59,23 @@ struct CppClassBindingImpl
     }
 };
 
-template<auto F>
+template<auto F, CppBinding::CheckPolicy Policy = CppBinding::CheckPolicy::kChecked>
 struct CppClassBinding;
 
-template<class C, class R, class ...Args, auto (C::*F)(Args...) ->R>
-struct CppClassBinding<F>
+template<class C, class R, class ...Args, auto (C::*F)(Args...) ->R, CppBinding::CheckPolicy Policy>
+struct CppClassBinding<F, Policy>
 {
     static Napi::Value call(C* instance, const Napi::CallbackInfo& info)
     {
-        return CppClassBindingImpl<F, C, R, Args...>::call(instance, info);
+        return CppClassBindingImpl<F, Policy, C, R, Args...>::call(instance, info);
     }
 };
 
-template<class C, class R, class ...Args, auto (C::* F)(Args...) const ->R>
-struct CppClassBinding<F>
+template<class C, class R, class ...Args, auto (C::* F)(Args...) const ->R, CppBinding::CheckPolicy Policy>
+struct CppClassBinding<F, Policy>
 {
     static Napi::Value call(C* instance, const Napi::CallbackInfo& info)
     {
-        return CppClassBindingImpl<F, C, R, Args...>::call(instance, info);
+        return CppClassBindingImpl<F, Policy, C, R, Args...>::call(instance, info);
     }
 };
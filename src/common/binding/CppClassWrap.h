@@ -0,0 +1,113 @@
+#pragma once
+
+#include <tuple>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+#include <napi.h>
+
+#include "CppBinding.h"
+#include "CppClassBinding.h"
+
+//
+// native class exposed through Napi::ObjectWrap : every js instance owns its C (built from CtorArgs converted
+// like function arguments) and frees it when collected. methods live on the prototype and reach the instance
+// through the wrap itself, no id / lookup table involved. registered with BindingHelper::beginClass
+//
+template <class C, class ... CtorArgs>
+class CppClassWrap : public Napi::ObjectWrap<CppClassWrap<C, CtorArgs...>>
+{
+    using Base = Napi::ObjectWrap<CppClassWrap<C, CtorArgs...>>;
+
+public:
+    using Property = typename Base::PropertyDescriptor;
+
+    static Napi::Function define(Napi::Env env, const char* name, const std::vector<Property>& properties)
+    {
+        auto constructor = Base::DefineClass(env, name, properties);
+        m_constructor = Napi::Persistent(constructor);
+        m_constructor.SuppressDestruct();
+        return constructor;
+    }
+
+    template <auto F>
+    static Property method(const char* name)
+    {
+        return Base::template InstanceMethod<&CppClassWrap::template call<F>>(name);
+    }
+
+    // the native object behind `value`, nullptr when it is not an instance of this class
+    static C* unwrap(const Napi::Value& value)
+    {
+        if (m_constructor.IsEmpty() || !value.IsObject() || !value.As<Napi::Object>().InstanceOf(m_constructor.Value()))
+            return nullptr;
+        return Base::Unwrap(value.As<Napi::Object>())->m_instance.get();
+    }
+
+    CppClassWrap(const Napi::CallbackInfo& info) : Base(info)
+    {
+        try
+        {
+            if constexpr (sizeof...(CtorArgs) > 0)
+            {
+                CppBinding::checkArgCountAndType<CtorArgs...>(info);
+                auto inputs = CppBinding::getDecayInputs<CtorArgs...>(info);
+                m_instance = CppBinding::invokeCpp(
+                    [](auto&& ... args) { return std::make_unique<C>(std::forward<decltype(args)>(args)...); },
+                    std::move(inputs), std::tuple<std::remove_reference_t<CtorArgs>...>{});
+            }
+            else
+            {
+                m_instance = std::make_unique<C>();
+            }
+        }
+        catch (std::runtime_error& err)
+        {
+            throw Napi::Error::New(info.Env(), err.what());
+        }
+    }
+
+private:
+    template <auto F>
+    Napi::Value call(const Napi::CallbackInfo& info)
+    {
+        return CppClassBinding<F>::call(m_instance.get(), info);
+    }
+
+    std::unique_ptr<C> m_instance;
+    inline static Napi::FunctionReference m_constructor;
+};
+
+// collects the prototype of a class between BindingHelper::beginClass and endClass
+template <class Helper, class C, class ... CtorArgs>
+class CppClassBuilder
+{
+    using Wrap = CppClassWrap<C, CtorArgs...>;
+
+public:
+    CppClassBuilder(Helper& helper, Napi::Env env, Napi::Object& target, const char* className)
+        : m_helper(helper), m_env(env), m_target(target), m_className(className) {}
+
+    template <auto F>
+    CppClassBuilder& addMethod(const char* methodName)
+    {
+        m_properties.push_back(Wrap::template method<F>(methodName));
+        return *this;
+    }
+
+    Helper& endClass()
+    {
+        m_target.Set(m_className, Wrap::define(m_env, m_className, m_properties));
+        return m_helper;
+    }
+
+private:
+    Helper& m_helper;
+    Napi::Env m_env;
+    Napi::Object& m_target;
+    const char* m_className;
+    std::vector<typename Wrap::Property> m_properties;
+};
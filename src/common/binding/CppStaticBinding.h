@@ -14,12 +14,13 @@
 #include "TypeDecay.h"
 #include "CallbackWrapper.h"
 #include "CppBinding.h"
+#include "CodedError.h"
 
-template<auto F>
+template<auto F, CppBinding::CheckPolicy Policy = CppBinding::CheckPolicy::kChecked>
 struct CppStaticBinding {};
 
-template<class R, class ...Args, auto (*F)(Args...)->R>
-struct CppStaticBinding<F>
+template<class R, class ...Args, auto (*F)(Args...)->R, CppBinding::CheckPolicy Policy>
+struct CppStaticBinding<F, Policy>
 {
     static Napi::Value call(const Napi::CallbackInfo& info)
     {
@@ -30,7 +31,7 @@ struct CppStaticBinding<F>
             constexpr auto parameterCount = sizeof...(Args);
             if constexpr (parameterCount > 0)
             {
-                CppBinding::checkArgCountAndType<Args...>(info);
+                CppBinding::checkArgs<Policy, Args...>(info);
                 return CppBinding::invoke<F, R, Args...>(info);
             }
             else
@@ -47,6 +48,12 @@ struct CppStaticBinding<F>
                 }
             }
         }
+        catch (const CodedError& err)
+        {
+            auto error = Napi::Error::New(info.Env(), err.what());
+            error.Set("code", Napi::String::New(info.Env(), err.code()));
+            throw error;
+        }
         catch (std::runtime_error& err)
         {
             throw Napi::Error::New(info.Env(), err.what());
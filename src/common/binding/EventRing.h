@@ -0,0 +1,149 @@
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+
+#include <napi.h>
+
+#include "CallbackWrapper.h"
+#include "common/utils/UseGuard.h"
+
+//
+// single producer ring over a js SharedArrayBuffer (see EventRing in native.ts), events are written
+// as frames [uint32 length][payload][pad to 4] without any napi call, js consumes by polling or
+// Atomics.waitAsync on kNotifySequence. the producer only hops to the js thread (to Atomics.notify)
+// when the consumer announced it is going to sleep through kWaiting, so busy streams never do
+//
+class EventRing
+{
+public:
+    // int32 header slots, followed by `capacity` bytes of frames
+    enum Header
+    {
+        kWriteIndex,
+        kReadIndex,
+        kCapacity,
+        kDropped,
+        kLagMax,
+        kWaiting,
+        kNotifySequence,
+        kFrames,
+        kHeaderSize
+    };
+
+    static constexpr uint32_t kWrapMarker = 0xFFFFFFFF;
+    // the smallest ring holding a frame with a payload (and room for a wrap marker)
+    static constexpr uint32_t kMinCapacity = 8;
+
+    static bool isRing(const Napi::Value& value)
+    {
+        return value.IsTypedArray() && value.As<Napi::TypedArray>().TypedArrayType() == napi_int32_array;
+    }
+
+    // must run on the js thread
+    static std::shared_ptr<EventRing> create(const Napi::Value& value)
+    {
+        Napi::Env env = value.Env();
+        auto array = value.As<Napi::Int32Array>();
+        if (array.ElementLength() < kHeaderSize)
+            throw Napi::RangeError::New(env, "event ring is smaller than its header");
+
+        auto header = array.Data();
+        auto capacity = static_cast<uint32_t>(header[kCapacity]);
+        if (capacity < kMinCapacity || (capacity & (capacity - 1)) != 0 || array.ByteLength() != kHeaderSize * sizeof(int32_t) + capacity)
+            throw Napi::RangeError::New(env, "event ring capacity should be a power of 2, at least 8, matching the buffer size");
+
+        // Atomics.notify bound to the ring, the tsfn keeps it (and so the SharedArrayBuffer) alive as long as the producer
+        auto notify = env.Global().Get("Atomics").As<Napi::Object>().Get("notify").As<Napi::Function>();
+        auto boundNotify = notify.Get("bind").As<Napi::Function>().Call(
+            notify, { env.Null(), array, Napi::Number::New(env, kNotifySequence) }).As<Napi::Function>();
+
+        auto ring = std::make_shared<EventRing>();
+        ring->m_header = header;
+        ring->m_data = reinterpret_cast<uint8_t*>(header + kHeaderSize);
+        ring->m_capacity = capacity;
+        ring->m_notify = std::make_shared<ThreadSafeFunctionWrapper>(
+            Napi::ThreadSafeFunction::New(env, boundNotify, "EventRingNotify", 0, 1));
+        return ring;
+    }
+
+    // producer thread only
+    bool write(const void* payload, size_t length)
+    {
+        if (!m_guard.enter())
+            return false;
+
+        bool written = push(payload, length);
+        m_guard.leave();
+        return written;
+    }
+
+    // stops writing and releases the notify function, which lets js collect the SharedArrayBuffer
+    void close()
+    {
+        if (m_guard.close())
+            m_notify.reset();
+    }
+
+private:
+    bool push(const void* payload, size_t length)
+    {
+        uint32_t frameSize = static_cast<uint32_t>(sizeof(uint32_t) + ((length + 3) & ~size_t(3)));
+        uint32_t write = slot(kWriteIndex).load(std::memory_order_relaxed);
+        uint32_t read = slot(kReadIndex).load(std::memory_order_acquire);
+
+        // a frame never straddles the end of the ring, so js can hand out a contiguous view
+        uint32_t offset = write & (m_capacity - 1);
+        uint32_t tail = m_capacity - offset;
+        uint32_t padding = tail < frameSize ? tail : 0;
+        if (length >= m_capacity || (write - read) + padding + frameSize > m_capacity)
+        {
+            slot(kDropped).fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        if (padding)
+        {
+            std::memcpy(m_data + offset, &kWrapMarker, sizeof(uint32_t));
+            write += padding;
+            offset = 0;
+        }
+
+        auto size = static_cast<uint32_t>(length);
+        std::memcpy(m_data + offset, &size, sizeof(uint32_t));
+        std::memcpy(m_data + offset + sizeof(uint32_t), payload, length);
+        write += frameSize;
+
+        // seq_cst, paired with the exchange of kWaiting below : a consumer announcing its sleep either sees this
+        // write or has its announcement seen, never neither
+        slot(kWriteIndex).store(static_cast<int32_t>(write), std::memory_order_seq_cst);
+        slot(kFrames).fetch_add(1, std::memory_order_relaxed);
+
+        auto lag = static_cast<int32_t>(write - read);
+        if (lag > slot(kLagMax).load(std::memory_order_relaxed))
+            slot(kLagMax).store(lag, std::memory_order_relaxed);
+
+        if (slot(kWaiting).exchange(0, std::memory_order_seq_cst) != 0)
+        {
+            slot(kNotifySequence).fetch_add(1, std::memory_order_release);
+            (*m_notify)->NonBlockingCall();
+        }
+        return true;
+    }
+
+    // the header is shared with js Atomics, which operate on the same 32 bit words
+    std::atomic<int32_t>& slot(Header index)
+    {
+        static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t), "std::atomic<int32_t> must be lock free and unpadded");
+        return *reinterpret_cast<std::atomic<int32_t>*>(m_header + index);
+    }
+
+    int32_t* m_header = nullptr;
+    uint8_t* m_data = nullptr;
+    uint32_t m_capacity = 0;
+    std::shared_ptr<ThreadSafeFunctionWrapper> m_notify;
+    UseGuard m_guard;
+};
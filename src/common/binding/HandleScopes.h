@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+#include <napi.h>
+
+#include "common/node/Node.h"
+
+//
+// estimate of the handles conversions keep alive (js thread only) : one per converted element / struct member,
+// given back when their container or struct conversion is done. reported (and its peak reset) by
+// Diagnostics.handles(), to keep large conversions flat. only counted when built with FBRPC_COUNT_HANDLES
+//
+class HandleCounter
+{
+public:
+    struct Stats
+    {
+        uint64_t live = 0;
+        uint64_t peak = 0;
+        uint64_t scopes = 0;
+    };
+
+    static Stats& stats()
+    {
+        static Stats stats;
+        return stats;
+    }
+
+    static void add(uint64_t count = 1)
+    {
+#ifdef FBRPC_COUNT_HANDLES
+        auto& s = stats();
+        s.live += count;
+        s.peak = std::max(s.peak, s.live);
+#endif
+    }
+
+    static Napi::Value report()
+    {
+        auto& s = stats();
+        auto result = Napi::Object::New(Node::getEnv());
+        result.Set("live", static_cast<double>(s.live));
+        result.Set("peak", static_cast<double>(s.peak));
+        result.Set("scopes", static_cast<double>(s.scopes));
+        s.peak = s.live;
+        return result;
+    }
+};
+
+//
+// container conversions open a new HandleScope every kChunkSize elements, so converting a 500k element
+// vector keeps at most one chunk of element handles alive instead of all of them until the binding returns.
+// the container itself must be created before, in the caller's scope. small containers don't open any
+//
+class ChunkedHandleScope
+{
+public:
+    static constexpr uint32_t kChunkSize = 1024;
+
+    ChunkedHandleScope(napi_env env, size_t size)
+        : m_env(env), m_chunked(size > kChunkSize), m_base(HandleCounter::stats().live) {}
+
+    ~ChunkedHandleScope()
+    {
+        close();
+        HandleCounter::stats().live = m_base;
+    }
+
+    ChunkedHandleScope(const ChunkedHandleScope&) = delete;
+    ChunkedHandleScope& operator =(const ChunkedHandleScope&) = delete;
+
+    // before converting each element
+    void next()
+    {
+        if (m_chunked && m_count++ % kChunkSize == 0)
+        {
+            close();
+            if (napi_open_handle_scope(m_env, &m_scope) != napi_ok)
+                throw Napi::Error::New(m_env);
+            ++HandleCounter::stats().scopes;
+        }
+        HandleCounter::add();
+    }
+
+private:
+    void close()
+    {
+        if (!m_scope)
+            return;
+        napi_close_handle_scope(m_env, m_scope);
+        m_scope = nullptr;
+        HandleCounter::stats().live = m_base;
+    }
+
+    napi_env m_env;
+    bool m_chunked;
+    uint64_t m_base;
+    uint64_t m_count = 0;
+    napi_handle_scope m_scope = nullptr;
+};
+
+// scope of one converted struct : its member handles are released, only the object escapes. only opened when
+// built with FBRPC_COUNT_HANDLES, the chunked container scopes already bound large conversions
+#ifdef FBRPC_COUNT_HANDLES
+class ObjectHandleScope
+{
+public:
+    ObjectHandleScope(napi_env env) : m_scope(env), m_saved(HandleCounter::stats().live)
+    {
+        ++HandleCounter::stats().scopes;
+    }
+
+    Napi::Value escape(const Napi::Value& value)
+    {
+        HandleCounter::stats().live = m_saved + 1;
+        return m_scope.Escape(value);
+    }
+
+private:
+    Napi::EscapableHandleScope m_scope;
+    uint64_t m_saved;
+};
+#else
+class ObjectHandleScope
+{
+public:
+    ObjectHandleScope(napi_env) {}
+
+    Napi::Value escape(const Napi::Value& value)
+    {
+        return value;
+    }
+};
+#endif
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <charconv>
+#include <type_traits>
+
+#include <napi.h>
+
+//
+// js Map / Set access for the associative container conversions. napi has no api for them, so they go through
+// the builtin Map / Set / Array functions, looked up once : Maps and Sets are built by one constructor call from an
+// array of entries / values, and read back as plain arrays by Array.from over their iterators
+//
+class JsCollections
+{
+public:
+    static bool isMap(const Napi::Value& value)
+    {
+        return value.IsObject() && value.As<Napi::Object>().InstanceOf(get(value.Env()).map.Value());
+    }
+
+    static bool isSet(const Napi::Value& value)
+    {
+        return value.IsObject() && value.As<Napi::Object>().InstanceOf(get(value.Env()).set.Value());
+    }
+
+    // `entries` : [key, value] arrays
+    static Napi::Value makeMap(const Napi::Env& env, const Napi::Array& entries)
+    {
+        return get(env).map.New({ entries });
+    }
+
+    // [keys, values] of a Map
+    static std::pair<Napi::Array, Napi::Array> entries(const Napi::Value& map)
+    {
+        auto& functions = get(map.Env());
+        return { toArray(functions, functions.mapKeys.Call(map, {})), toArray(functions, functions.mapValues.Call(map, {})) };
+    }
+
+    static Napi::Value makeSet(const Napi::Env& env, const Napi::Array& values)
+    {
+        return get(env).set.New({ values });
+    }
+
+    static Napi::Array values(const Napi::Value& set)
+    {
+        return toArray(get(set.Env()), set);
+    }
+
+    // plain objects stand for maps with integer keys, their property names must then be integers
+    template <class K>
+    static bool parseKey(const std::string& name, K& key)
+    {
+        static_assert(std::is_integral_v<K>);
+        auto end = name.data() + name.size();
+        auto [ptr, error] = std::from_chars(name.data(), end, key);
+        return error == std::errc() && ptr == end;
+    }
+
+private:
+    struct Functions
+    {
+        Napi::FunctionReference map;
+        Napi::FunctionReference set;
+        Napi::FunctionReference mapKeys;
+        Napi::FunctionReference mapValues;
+        Napi::FunctionReference array;
+        Napi::FunctionReference arrayFrom;
+    };
+
+    static Napi::Array toArray(Functions& functions, const Napi::Value& iterable)
+    {
+        return functions.arrayFrom.Call(functions.array.Value(), { iterable }).As<Napi::Array>();
+    }
+
+    static Functions& get(const Napi::Env& env)
+    {
+        static Functions functions;
+        if (functions.map.IsEmpty())
+        {
+            auto global = env.Global();
+            auto map = global.Get("Map").As<Napi::Function>();
+            auto mapPrototype = map.Get("prototype").As<Napi::Object>();
+            auto array = global.Get("Array").As<Napi::Function>();
+
+            functions.map = Napi::Persistent(map);
+            functions.set = Napi::Persistent(global.Get("Set").As<Napi::Function>());
+            functions.mapKeys = Napi::Persistent(mapPrototype.Get("keys").As<Napi::Function>());
+            functions.mapValues = Napi::Persistent(mapPrototype.Get("values").As<Napi::Function>());
+            functions.array = Napi::Persistent(array);
+            functions.arrayFrom = Napi::Persistent(array.Get("from").As<Napi::Function>());
+
+            for (auto reference : { &functions.map, &functions.set, &functions.mapKeys, &functions.mapValues,
+                &functions.array, &functions.arrayFrom })
+                reference->SuppressDestruct();
+        }
+        return functions;
+    }
+};
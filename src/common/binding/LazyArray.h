@@ -0,0 +1,214 @@
+#pragma once
+
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
+#include <napi.h>
+
+#include "TypeConversion.h"
+
+//
+// opt-in return type for large containers : instead of converting every element up front,
+// js receives a native backed view { length, at(i), slice(begin, end), [Symbol.iterator] }
+// and elements are converted on access. eg : static LazyArray<std::vector<Row>> query(...)
+//
+template <class Container>
+struct LazyArray
+{
+    LazyArray() = default;
+    LazyArray(Container&& container) : data(std::make_shared<const Container>(std::move(container))) {}
+
+    std::shared_ptr<const Container> data;
+};
+
+template <class Container>
+class LazyArrayIteratorWrap : public Napi::ObjectWrap<LazyArrayIteratorWrap<Container>>
+{
+    using Base = Napi::ObjectWrap<LazyArrayIteratorWrap<Container>>;
+    using Data = std::shared_ptr<const Container>;
+
+public:
+    static Napi::Object create(const Napi::Env& env, Data data)
+    {
+        if (m_constructor.IsEmpty())
+        {
+            m_constructor = Napi::Persistent(Base::DefineClass(env, "LazyArrayIterator", {
+                Base::InstanceMethod("next", &LazyArrayIteratorWrap::next)
+            }));
+            m_constructor.SuppressDestruct();
+        }
+        return m_constructor.New({ Napi::External<Data>::New(env, &data) });
+    }
+
+    LazyArrayIteratorWrap(const Napi::CallbackInfo& info) : Base(info)
+    {
+        if (info.Length() != 1 || !info[0].IsExternal())
+            throw Napi::TypeError::New(info.Env(), "LazyArrayIterator can't be constructed from javascript");
+
+        // the iterator shares the container, so it stays valid even if the array view is collected first
+        m_data = *info[0].As<Napi::External<Data>>().Data();
+        m_cursor = m_data->begin();
+    }
+
+private:
+    Napi::Value next(const Napi::CallbackInfo& info)
+    {
+        Napi::Env env = info.Env();
+        auto result = Napi::Object::New(env);
+        if (m_cursor == m_data->end())
+        {
+            result.Set("done", true);
+            result.Set("value", env.Undefined());
+        }
+        else
+        {
+            result.Set("done", false);
+            result.Set("value", TypeConversion::CppToJs<typename Container::value_type>::convert(env, *m_cursor++));
+        }
+        return result;
+    }
+
+    Data m_data;
+    typename Container::const_iterator m_cursor;
+    inline static Napi::FunctionReference m_constructor;
+};
+
+template <class Container>
+class LazyArrayWrap : public Napi::ObjectWrap<LazyArrayWrap<Container>>
+{
+    using Base = Napi::ObjectWrap<LazyArrayWrap<Container>>;
+    using Data = std::shared_ptr<const Container>;
+    using Element = typename Container::value_type;
+    using Iterator = typename Container::const_iterator;
+
+    static constexpr bool IsRandomAccess =
+        std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>;
+
+public:
+    static Napi::Object create(const Napi::Env& env, Data data)
+    {
+        if (m_constructor.IsEmpty())
+        {
+            m_constructor = Napi::Persistent(Base::DefineClass(env, "LazyArray", {
+                Base::InstanceAccessor("length", &LazyArrayWrap::length, nullptr, napi_enumerable),
+                Base::InstanceMethod("at", &LazyArrayWrap::at),
+                Base::InstanceMethod("slice", &LazyArrayWrap::slice),
+                Base::InstanceMethod(Napi::Symbol::WellKnown(env, "iterator"), &LazyArrayWrap::iterator)
+            }));
+            m_constructor.SuppressDestruct();
+        }
+        return m_constructor.New({ Napi::External<Data>::New(env, &data) });
+    }
+
+    LazyArrayWrap(const Napi::CallbackInfo& info) : Base(info)
+    {
+        if (info.Length() != 1 || !info[0].IsExternal())
+            throw Napi::TypeError::New(info.Env(), "LazyArray can't be constructed from javascript");
+
+        m_data = *info[0].As<Napi::External<Data>>().Data();
+        m_cursor = m_data->begin();
+
+        // let v8 know about the native memory it keeps alive, so gc is not delayed by large results
+        m_externalSize = static_cast<int64_t>(sizeof(Container) + m_data->size() * sizeof(Element));
+        Napi::MemoryManagement::AdjustExternalMemory(info.Env(), m_externalSize);
+    }
+
+    ~LazyArrayWrap()
+    {
+        Napi::MemoryManagement::AdjustExternalMemory(this->Env(), -m_externalSize);
+    }
+
+private:
+    Napi::Value length(const Napi::CallbackInfo& info)
+    {
+        return Napi::Number::New(info.Env(), static_cast<double>(m_data->size()));
+    }
+
+    Napi::Value at(const Napi::CallbackInfo& info)
+    {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber())
+            throw Napi::TypeError::New(env, "index should be a number");
+
+        auto size = static_cast<int64_t>(m_data->size());
+        auto index = info[0].As<Napi::Number>().Int64Value();
+        if (index < 0)
+            index += size;
+
+        if (index < 0 || index >= size)
+            return env.Undefined();
+
+        return TypeConversion::CppToJs<Element>::convert(env, element(static_cast<size_t>(index)));
+    }
+
+    // same semantics as Array.prototype.slice, the returned page is a plain js array
+    Napi::Value slice(const Napi::CallbackInfo& info)
+    {
+        Napi::Env env = info.Env();
+        auto size = static_cast<int64_t>(m_data->size());
+        auto begin = relativeIndex(info, 0, 0, size);
+        auto end = relativeIndex(info, 1, size, size);
+
+        auto result = Napi::Array::New(env, static_cast<size_t>(std::max<int64_t>(end - begin, 0)));
+        for (auto i = begin; i < end; ++i)
+            result[static_cast<uint32_t>(i - begin)] = TypeConversion::CppToJs<Element>::convert(env, element(static_cast<size_t>(i)));
+        return result;
+    }
+
+    Napi::Value iterator(const Napi::CallbackInfo& info)
+    {
+        return LazyArrayIteratorWrap<Container>::create(info.Env(), m_data);
+    }
+
+    static int64_t relativeIndex(const Napi::CallbackInfo& info, size_t arg, int64_t defaultValue, int64_t size)
+    {
+        if (info.Length() <= arg || info[arg].IsUndefined())
+            return defaultValue;
+
+        if (!info[arg].IsNumber())
+            throw Napi::TypeError::New(info.Env(), "index should be a number");
+
+        auto index = info[arg].As<Napi::Number>().Int64Value();
+        return index < 0 ? std::max<int64_t>(size + index, 0) : std::min(index, size);
+    }
+
+    const Element& element(size_t index)
+    {
+        if constexpr (IsRandomAccess)
+        {
+            return *(m_data->begin() + index);
+        }
+        else
+        {
+            // lists are paged through sequentially, keep a cursor so that stays O(1) per element
+            if (index < m_cursorIndex)
+            {
+                m_cursor = m_data->begin();
+                m_cursorIndex = 0;
+            }
+            std::advance(m_cursor, index - m_cursorIndex);
+            m_cursorIndex = index;
+            return *m_cursor;
+        }
+    }
+
+    Data m_data;
+    Iterator m_cursor;
+    size_t m_cursorIndex = 0;
+    int64_t m_externalSize = 0;
+    inline static Napi::FunctionReference m_constructor;
+};
+
+namespace TypeConversion
+{
+    template <class Container>
+    struct CppToJs<LazyArray<Container>>
+    {
+        static Napi::Value convert(const Napi::Env& env, const LazyArray<Container>& value)
+        {
+            return LazyArrayWrap<Container>::create(env, value.data ? value.data : std::make_shared<const Container>());
+        }
+    };
+}
@@ -5,6 +5,8 @@
 #include <functional>
 #include <napi.h>
 
+#include "HandleScopes.h"
+
 namespace PODTypeBinding
 {
 
@@ -75,6 +77,7 @@ namespace PODTypeBinding
 
         void toJs(Napi::Object &obj, const ClassType &instance) const
         {
+            HandleCounter::add();
             obj[key] = TypeConversion::CppToJs<MemberType>::convert(obj.Env(), instance.*value);
         }
 
@@ -107,6 +110,7 @@ namespace PODTypeBinding
 
         void toJs(Napi::Object &obj, const ClassType &instance) const
         {
+            HandleCounter::add();
             obj[key] = TypeConversion::CppToJs<MemberType>::convert(obj.Env(), (instance.*(std::get<0>(value)))());
         }
 
@@ -153,9 +157,11 @@ namespace PODTypeBinding
         template <class T, std::size_t... I>
         Napi::Value toJs(const Napi::Env &env, const T &instance, std::index_sequence<I...>) const
         {
+            // member handles (keys, values, nested objects) die with the scope, only the object escapes
+            ObjectHandleScope scope(env);
             Napi::Object obj = Napi::Object::New(env);
             (std::get<I>(t).toJs(obj, instance), ...);
-            return obj;
+            return scope.escape(obj);
         }
 
         template <class T>
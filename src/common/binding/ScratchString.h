@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include <cstring>
+#include <string_view>
+
+#include <napi.h>
+
+//
+// utf8 copy of a js string backing std::string_view and const char* parameters (see TypeDecay), read with
+// napi_get_value_string_utf8 straight into an inline buffer, so short strings never touch the heap
+//
+class ScratchString
+{
+public:
+    static constexpr size_t kInlineSize = 256;
+
+    ScratchString() = default;
+
+    explicit ScratchString(const Napi::Value& value)
+    {
+        napi_env env = value.Env();
+        if (napi_get_value_string_utf8(env, value, m_inline, kInlineSize, &m_size) != napi_ok)
+            throw Napi::Error::New(env);
+
+        // v8 does not split a multi byte character, so a nearly full buffer may hide a truncated string
+        if (m_size + 4 < kInlineSize)
+            return;
+
+        size_t size = 0;
+        if (napi_get_value_string_utf8(env, value, nullptr, 0, &size) != napi_ok)
+            throw Napi::Error::New(env);
+        if (size == m_size)
+            return;
+
+        m_heap = std::make_unique<char[]>(size + 1);
+        if (napi_get_value_string_utf8(env, value, m_heap.get(), size + 1, &m_size) != napi_ok)
+            throw Napi::Error::New(env);
+    }
+
+    ScratchString(ScratchString&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    ScratchString& operator =(ScratchString&& other) noexcept
+    {
+        m_size = other.m_size;
+        m_heap = std::move(other.m_heap);
+        if (!m_heap)
+            std::memcpy(m_inline, other.m_inline, m_size + 1);
+        return *this;
+    }
+
+    ScratchString(const ScratchString&) = delete;
+    ScratchString& operator =(const ScratchString&) = delete;
+
+    const char* c_str() const
+    {
+        return m_heap ? m_heap.get() : m_inline;
+    }
+
+    std::string_view view() const
+    {
+        return { c_str(), m_size };
+    }
+
+private:
+    char m_inline[kInlineSize] = {};
+    std::unique_ptr<char[]> m_heap;
+    size_t m_size = 0;
+};
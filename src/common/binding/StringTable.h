@@ -0,0 +1,114 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstring>
+
+#include <napi.h>
+
+#include "TypeCheck.h"
+#include "TypeConversion.h"
+
+//
+// opt-in packed form of std::vector<std::string> : all strings cross the boundary as
+// { bytes : Uint8Array (utf-8), offsets : Uint32Array (length + 1) }, a constant number of napi calls
+// whatever the string count. js decodes lazily with StringTable (native.ts) and packs with StringTable.pack,
+// a plain string array is still accepted as input
+//
+struct StringTable
+{
+    std::vector<std::string> strings;
+};
+
+template<>
+struct TypeCheck<StringTable>
+{
+    static bool check(const Napi::Value& value)
+    {
+        if (value.IsArray())
+            return TypeCheck<std::vector<std::string>>::check(value);
+
+        if (!value.IsObject())
+            return false;
+
+        // JsToCpp reads them as raw uint8 / uint32 data
+        auto obj = value.As<Napi::Object>();
+        return isTypedArray(obj.Get("bytes"), napi_uint8_array) && isTypedArray(obj.Get("offsets"), napi_uint32_array);
+    }
+
+private:
+    static bool isTypedArray(const Napi::Value& value, napi_typedarray_type type)
+    {
+        return value.IsTypedArray() && value.As<Napi::TypedArray>().TypedArrayType() == type;
+    }
+};
+
+namespace TypeConversion
+{
+    template<>
+    struct CppToJs<StringTable>
+    {
+        static Napi::Value convert(const Napi::Env& env, const StringTable& value)
+        {
+            auto& strings = value.strings;
+
+            size_t total = 0;
+            for (auto& str : strings)
+                total += str.size();
+
+            if (total > std::numeric_limits<uint32_t>::max())
+                throw Napi::RangeError::New(env, "string table is larger than 4GB");
+
+            auto bytes = Napi::Uint8Array::New(env, total);
+            auto offsets = Napi::Uint32Array::New(env, strings.size() + 1);
+
+            auto data = bytes.Data();
+            auto offsetData = offsets.Data();
+            uint32_t offset = 0;
+            for (size_t i = 0; i < strings.size(); ++i)
+            {
+                offsetData[i] = offset;
+                std::memcpy(data + offset, strings[i].data(), strings[i].size());
+                offset += static_cast<uint32_t>(strings[i].size());
+            }
+            offsetData[strings.size()] = offset;
+
+            auto result = Napi::Object::New(env);
+            result.Set("bytes", bytes);
+            result.Set("offsets", offsets);
+            return result;
+        }
+    };
+
+    template<>
+    struct JsToCpp<StringTable>
+    {
+        static StringTable convert(const Napi::Value& value)
+        {
+            if (value.IsArray())
+                return { JsToCpp<std::vector<std::string>>::convert(value) };
+
+            auto obj = value.As<Napi::Object>();
+            auto bytes = obj.Get("bytes").As<Napi::Uint8Array>();
+            auto offsets = obj.Get("offsets").As<Napi::Uint32Array>();
+
+            auto data = reinterpret_cast<const char*>(bytes.Data());
+            auto offsetData = offsets.Data();
+            auto count = offsets.ElementLength() > 0 ? offsets.ElementLength() - 1 : 0;
+
+            StringTable result;
+            result.strings.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto begin = offsetData[i];
+                auto end = offsetData[i + 1];
+                if (begin > end || end > bytes.ElementLength())
+                    throw Napi::RangeError::New(value.Env(), "invalid string table offsets");
+
+                result.strings.emplace_back(data + begin, end - begin);
+            }
+            return result;
+        }
+    };
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+#include <stdexcept>
+#include <functional>
+
+#include <napi.h>
+
+#include "CallbackWrapper.h"
+#include "EventRing.h"
+#include "common/node/Node.h"
+
+//
+// unsubscribe handle : `Subscriptions.create(callback or ring)` gives an object that is passed to a generated
+// subscribe* function in place of the callback, `unsubscribe()` then closes every native channel bound to it
+// (releasing the thread safe functions, dropping the queued events). an active subscription is kept alive
+// by the native side, so a forgotten one still shows up in `Subscriptions.count()`
+//
+class Subscription : public Napi::ObjectWrap<Subscription>
+{
+    using Base = Napi::ObjectWrap<Subscription>;
+
+public:
+    // latest value per key delivery, see EventConflator
+    struct Conflation
+    {
+        std::string rootType;
+        std::string keyField;
+    };
+
+    static Napi::Value create(Napi::Value target)
+    {
+        Napi::Env env = target.Env();
+        if (m_constructor.IsEmpty())
+        {
+            m_constructor = Napi::Persistent(DefineClass(env, "Subscription", {
+                InstanceMethod("unsubscribe", &Subscription::unsubscribe),
+                InstanceAccessor("active", &Subscription::active, nullptr, napi_enumerable)
+            }));
+            m_constructor.SuppressDestruct();
+        }
+        return m_constructor.New({ target });
+    }
+
+    // `callback` then receives arrays of the newest event of each key changed since the previous call
+    static Napi::Value conflate(Napi::Function callback, std::string rootType, std::string keyField)
+    {
+        auto object = create(callback);
+        Unwrap(object.As<Napi::Object>())->m_conflation = Conflation{ std::move(rootType), std::move(keyField) };
+        return object;
+    }
+
+    static Napi::Value count()
+    {
+        return Napi::Number::New(Node::getEnv(), static_cast<double>(m_live));
+    }
+
+    // the subscription behind `value`, nullptr for anything else
+    static Subscription* unwrap(const Napi::Value& value)
+    {
+        if (m_constructor.IsEmpty() || !value.IsObject() || !value.As<Napi::Object>().InstanceOf(m_constructor.Value()))
+            return nullptr;
+        return Unwrap(value.As<Napi::Object>());
+    }
+
+    Subscription(const Napi::CallbackInfo& info) : Base(info)
+    {
+        if (info.Length() != 1 || !(info[0].IsFunction() || EventRing::isRing(info[0])))
+            throw Napi::TypeError::New(info.Env(), "a subscription expects a callback or an event ring");
+
+        m_target = Napi::Persistent(info[0]);
+        Ref();
+        ++m_live;
+    }
+
+    ~Subscription()
+    {
+        close();
+    }
+
+    bool isActive() const
+    {
+        return m_active;
+    }
+
+    const std::optional<Conflation>& conflation() const
+    {
+        return m_conflation;
+    }
+
+    // the callback or the ring Int32Array
+    Napi::Value target() const
+    {
+        return m_target.Value();
+    }
+
+    template <class Ret, class ... Args>
+    std::function<Ret(Args...)> bind()
+    {
+        if (!m_active)
+            throw std::runtime_error("the subscription was unsubscribed");
+
+        std::shared_ptr<CallbackChannel> channel;
+        auto function = CallbackWrapper::create<Ret, Args...>(target().As<Napi::Function>(), &channel);
+        attach([channel] { channel->close(); });
+        return function;
+    }
+
+    // `close` runs on unsubscribe, right away if that already happened
+    void attach(std::function<void()> close)
+    {
+        if (m_active)
+            m_closers.push_back(std::move(close));
+        else
+            close();
+    }
+
+private:
+    Napi::Value unsubscribe(const Napi::CallbackInfo& info)
+    {
+        if (m_active)
+        {
+            close();
+            Unref();
+        }
+        return info.Env().Undefined();
+    }
+
+    Napi::Value active(const Napi::CallbackInfo& info)
+    {
+        return Napi::Boolean::New(info.Env(), m_active);
+    }
+
+    void close()
+    {
+        if (!m_active)
+            return;
+
+        m_active = false;
+        --m_live;
+        for (auto& closer : m_closers)
+            closer();
+        m_closers.clear();
+    }
+
+    bool m_active = true;
+    Napi::Reference<Napi::Value> m_target;
+    std::optional<Conflation> m_conflation;
+    std::vector<std::function<void()>> m_closers;
+
+    inline static size_t m_live = 0;
+    inline static Napi::FunctionReference m_constructor;
+};
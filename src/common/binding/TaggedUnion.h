@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <cstdint>
+#include <utility>
+#include <variant>
+#include <type_traits>
+
+#include <napi.h>
+
+//
+// std::variant and flatbuffers object api unions (eg : AnyUnion) are both exchanged as { type, value } objects,
+// always created with the same two properties so they share one hidden class. `type` is the variant index or
+// the union tag (0 being NONE, with a null value). conversions index a table of per alternative functions
+// with `type`, so an alternative costs a single indirect call whatever its position, without trial conversions
+//
+namespace TaggedUnion
+{
+    constexpr const char* kType = "type";
+    constexpr const char* kValue = "value";
+
+    // declared by fbrpc_generator per object api union, table types in tag order (tag 1 first) :
+    //   template <> struct TaggedUnion::Types<AnyUnion> { using List = std::tuple<MonsterT, WeaponT>; };
+    template <class U>
+    struct Types {};
+
+    template <class U, class Enable = void>
+    struct IsUnion : std::false_type {};
+
+    template <class U>
+    struct IsUnion<U, std::void_t<typename Types<U>::List>> : std::true_type {};
+
+    template <class U>
+    constexpr bool isUnion = IsUnion<U>::value;
+
+    // `Entry<I>::call` for each alternative, function pointers of the same signature
+    template <template <std::size_t> class Entry, std::size_t ... I>
+    constexpr auto makeTable(std::index_sequence<I...>)
+    {
+        return std::array{ &Entry<I>::call... };
+    }
+
+    inline Napi::Object make(const Napi::Env& env, uint32_t type, const Napi::Value& value)
+    {
+        auto result = Napi::Object::New(env);
+        result.Set(kType, type);
+        result.Set(kValue, value);
+        return result;
+    }
+
+    // `type` of a tagged object, `count` when it is not one or out of range
+    inline uint32_t typeOf(const Napi::Value& value, uint32_t count)
+    {
+        if (!value.IsObject())
+            return count;
+
+        Napi::Value type = value.As<Napi::Object>().Get(kType);
+        if (!type.IsNumber())
+            return count;
+
+        auto index = type.As<Napi::Number>().Int64Value();
+        return index >= 0 && index < count ? static_cast<uint32_t>(index) : count;
+    }
+}
@@ -1,13 +1,22 @@
 #pragma once
 
 #include <type_traits>
+#include <memory>
 #include <vector>
 #include <list>
+#include <set>
+#include <map>
 #include <unordered_set>
+#include <unordered_map>
+#include <variant>
 #include <napi.h>
 
 #include <Windows.h>
 
+#include "ScratchString.h"
+#include "TaggedUnion.h"
+#include "JsCollections.h"
+
 template<class T>
 struct DeduceFunctionType;
 
@@ -30,6 +39,15 @@ struct TypeCheck<Napi::Function>
 };
 
 
+template<class T>
+struct TypeCheck<Napi::Buffer<T>>
+{
+    static bool check(const Napi::Value& value)
+    {
+        return value.IsBuffer();
+    }
+};
+
 template<>
 struct TypeCheck<Napi::Value>
 {
@@ -55,6 +73,8 @@ struct TypeCheck<T, std::enable_if_t<std::is_integral_v<T> || std::is_floating_p
     {
         if constexpr (std::is_same_v<T, bool>)
             return value.IsBoolean();
+        else if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>)
+            return value.IsNumber() || value.IsBigInt();
         else
             return value.IsNumber();
     }
@@ -103,7 +123,7 @@ struct TypeCheck<std::tuple<Args...>>
 };
 
 template<class T>
-struct TypeCheck<T, std::enable_if_t<std::is_same_v<std::string, T>>>
+struct TypeCheck<T, std::enable_if_t<std::is_same_v<std::string, T> || std::is_same_v<ScratchString, T>>>
 {
     static bool check(const Napi::Value& value)
     {
@@ -120,6 +140,74 @@ struct TypeCheck<std::function<Ret(Args...)>>
     }
 };
 
+template<class T>
+struct TypeCheck<std::unique_ptr<T>>
+{
+    static bool check(const Napi::Value& value)
+    {
+        return value.IsNull() || value.IsUndefined() || TypeCheck<T>::check(value);
+    }
+};
+
+template<>
+struct TypeCheck<std::monostate>
+{
+    static bool check(const Napi::Value& value)
+    {
+        return value.IsNull() || value.IsUndefined();
+    }
+};
+
+// { type, value } objects, see TaggedUnion
+template<class ... Ts>
+struct TypeCheck<std::variant<Ts...>>
+{
+    template<std::size_t I>
+    struct Entry
+    {
+        static bool call(const Napi::Value& value)
+        {
+            return TypeCheck<std::variant_alternative_t<I, std::variant<Ts...>>>::check(value);
+        }
+    };
+
+    static bool check(const Napi::Value& value)
+    {
+        static constexpr auto kChecks = TaggedUnion::makeTable<Entry>(std::index_sequence_for<Ts...>{});
+        auto index = TaggedUnion::typeOf(value, sizeof...(Ts));
+        return index < sizeof...(Ts) && kChecks[index](value.As<Napi::Object>().Get(TaggedUnion::kValue));
+    }
+};
+
+template<class U>
+struct TypeCheck<U, std::enable_if_t<TaggedUnion::isUnion<U>>>
+{
+    using List = typename TaggedUnion::Types<U>::List;
+    static constexpr uint32_t kCount = std::tuple_size_v<List> + 1;
+
+    template<std::size_t I>
+    struct Entry
+    {
+        static bool call(const Napi::Value& value)
+        {
+            if constexpr (I == 0)
+                return value.IsNull() || value.IsUndefined();
+            else
+                return TypeCheck<std::tuple_element_t<I - 1, List>>::check(value);
+        }
+    };
+
+    static bool check(const Napi::Value& value)
+    {
+        if (value.IsNull() || value.IsUndefined())
+            return true;
+
+        static constexpr auto kChecks = TaggedUnion::makeTable<Entry>(std::make_index_sequence<kCount>{});
+        auto tag = TaggedUnion::typeOf(value, kCount);
+        return tag < kCount && kChecks[tag](value.As<Napi::Object>().Get(TaggedUnion::kValue));
+    }
+};
+
 template<class T>
 struct TypeCheckContainer
 {
@@ -149,5 +237,58 @@ struct TypeCheck<std::vector<T, Alloc>> : TypeCheckContainer<T> {};
 template<class T, class Alloc>
 struct TypeCheck<std::list<T, Alloc>> : TypeCheckContainer<T> {};
 
+// arrays or Sets. the elements of a Set are checked by JsToCpp as it converts them, reading them out twice
+// would copy the whole Set once more
+template<class T>
+struct TypeCheckSet
+{
+    static bool check(const Napi::Value& value)
+    {
+        return JsCollections::isSet(value) || TypeCheckContainer<T>::check(value);
+    }
+};
+
+template<class T>
+struct TypeCheck<std::unordered_set<T>> : TypeCheckSet<T> {};
+
 template<class T>
-struct TypeCheck<std::unordered_set<T>> : TypeCheckContainer<T> {};
+struct TypeCheck<std::set<T>> : TypeCheckSet<T> {};
+
+// Maps, or plain objects for integer keys. like Sets, the entries of a Map are checked on conversion
+template<class K, class V>
+struct TypeCheckMap
+{
+    static bool check(const Napi::Value& value)
+    {
+        if (value.IsNull() || value.IsUndefined())
+            return true;
+
+        if (JsCollections::isMap(value))
+            return true;
+
+        if constexpr (std::is_integral_v<K>)
+        {
+            if (!value.IsObject() || value.IsArray())
+                return false;
+
+            auto object = value.As<Napi::Object>();
+            auto names = object.GetPropertyNames();
+            auto length = names.Length();
+            for (uint32_t i = 0; i < length; ++i)
+            {
+                Napi::Value name = names[i];
+                K key;
+                if (!JsCollections::parseKey(name.As<Napi::String>().Utf8Value(), key) || !TypeCheck<V>::check(object.Get(name)))
+                    return false;
+            }
+            return true;
+        }
+        return false;
+    }
+};
+
+template<class K, class V>
+struct TypeCheck<std::unordered_map<K, V>> : TypeCheckMap<K, V> {};
+
+template<class K, class V>
+struct TypeCheck<std::map<K, V>> : TypeCheckMap<K, V> {};
@@ -3,11 +3,22 @@
 #include <type_traits>
 #include <tuple>
 #include <optional>
+#include <memory>
+#include <variant>
+#include <set>
+#include <map>
+#include <unordered_set>
+#include <unordered_map>
 
 #include <windows.h>
 #include <napi.h>
 
 #include "CallbackWrapper.h"
+#include "ScratchString.h"
+#include "HandleScopes.h"
+#include "TaggedUnion.h"
+#include "JsCollections.h"
+#include "TypeCheck.h"
 
 template<class T>
 struct DeduceFunctionType;
@@ -68,6 +79,15 @@ namespace TypeConversion
         }
     };
 
+    template<>
+    struct CppToJs<std::string_view>
+    {
+        static Napi::Value convert(const Napi::Env& env, const std::string_view& value)
+        {
+            return Napi::String::New(env, value.data(), value.size());
+        }
+    };
+
     template <class T>
     struct CppToJs<std::tuple<std::unique_ptr<T[]>, int>>
     {
@@ -94,8 +114,12 @@ namespace TypeConversion
         static Napi::Value convert(const Napi::Env& env, const std::vector<T, Alloc>& value)
         {
             auto vec = Napi::Array::New(env, value.size());
+            ChunkedHandleScope scope(env, value.size());
             for (std::uint32_t i = 0; i < value.size(); ++i)
+            {
+                scope.next();
                 vec[i] = TypeConversion::CppToJs<T>::convert(env, value[i]);
+            }
             return vec;
         }
     };
@@ -107,13 +131,68 @@ namespace TypeConversion
 		static Napi::Value convert(const Napi::Env& env, const std::list<T, Alloc>& value)
 		{
 			auto vec = Napi::Array::New(env, value.size());
+            ChunkedHandleScope scope(env, value.size());
             std::uint32_t i = 0;
 			for (auto it = value.begin(); it != value.end(); ++it)
+			{
+				scope.next();
 				vec[i++] = TypeConversion::CppToJs<T>::convert(env, *it);
+			}
 			return vec;
 		}
 	};
 
+    // Set built from one array
+    template<class Set>
+    struct CppToJsSet
+    {
+        static Napi::Value convert(const Napi::Env& env, const Set& value)
+        {
+            auto values = Napi::Array::New(env, value.size());
+            ChunkedHandleScope scope(env, value.size());
+            std::uint32_t i = 0;
+            for (auto& element : value)
+            {
+                scope.next();
+                values[i++] = CppToJs<typename Set::value_type>::convert(env, element);
+            }
+            return JsCollections::makeSet(env, values);
+        }
+    };
+
+    template<class T>
+    struct CppToJs<std::unordered_set<T>> : CppToJsSet<std::unordered_set<T>> {};
+
+    template<class T>
+    struct CppToJs<std::set<T>> : CppToJsSet<std::set<T>> {};
+
+    // Map built from one array of [key, value] entries
+    template<class Map>
+    struct CppToJsMap
+    {
+        static Napi::Value convert(const Napi::Env& env, const Map& value)
+        {
+            auto entries = Napi::Array::New(env, value.size());
+            ChunkedHandleScope scope(env, value.size());
+            std::uint32_t i = 0;
+            for (auto& [key, element] : value)
+            {
+                scope.next();
+                auto entry = Napi::Array::New(env, 2);
+                entry[0u] = CppToJs<typename Map::key_type>::convert(env, key);
+                entry[1u] = CppToJs<typename Map::mapped_type>::convert(env, element);
+                entries[i++] = entry;
+            }
+            return JsCollections::makeMap(env, entries);
+        }
+    };
+
+    template<class K, class V>
+    struct CppToJs<std::unordered_map<K, V>> : CppToJsMap<std::unordered_map<K, V>> {};
+
+    template<class K, class V>
+    struct CppToJs<std::map<K, V>> : CppToJsMap<std::map<K, V>> {};
+
     template<class ... Args>
     struct CppToJs<std::tuple<Args...>>
     {
@@ -132,6 +211,18 @@ namespace TypeConversion
         }
     };
 
+    template<class T>
+    struct CppToJs<std::unique_ptr<T>>
+    {
+        static Napi::Value convert(const Napi::Env& env, const std::unique_ptr<T>& value)
+        {
+            if (value)
+                return CppToJs<T>::convert(env, *value);
+            else
+                return env.Null();
+        }
+    };
+
     template<class T>
     struct CppToJs<std::optional<T>>
     {
@@ -144,6 +235,71 @@ namespace TypeConversion
         }
     };
 
+    template<>
+    struct CppToJs<std::monostate>
+    {
+        static Napi::Value convert(const Napi::Env& env, const std::monostate&)
+        {
+            return env.Null();
+        }
+    };
+
+    // { type: index, value }, see TaggedUnion
+    template<class ... Ts>
+    struct CppToJs<std::variant<Ts...>>
+    {
+        using Variant = std::variant<Ts...>;
+
+        template<std::size_t I>
+        struct Entry
+        {
+            static Napi::Value call(const Napi::Env& env, const Variant& value)
+            {
+                return CppToJs<std::variant_alternative_t<I, Variant>>::convert(env, *std::get_if<I>(&value));
+            }
+        };
+
+        static Napi::Value convert(const Napi::Env& env, const Variant& value)
+        {
+            static constexpr auto kConverters = TaggedUnion::makeTable<Entry>(std::index_sequence_for<Ts...>{});
+            if (value.valueless_by_exception())
+                return env.Null();
+
+            auto index = value.index();
+            return TaggedUnion::make(env, static_cast<uint32_t>(index), kConverters[index](env, value));
+        }
+    };
+
+    // object api unions : { type: tag, value }, value is null for NONE and for tags this build does not know
+    template<class U>
+    struct CppToJs<U, std::enable_if_t<TaggedUnion::isUnion<U>>>
+    {
+        using List = typename TaggedUnion::Types<U>::List;
+        static constexpr uint32_t kCount = std::tuple_size_v<List> + 1;
+
+        template<std::size_t I>
+        struct Entry
+        {
+            static Napi::Value call(const Napi::Env& env, const void* value)
+            {
+                if constexpr (I == 0)
+                    return env.Null();
+                else
+                {
+                    using T = std::tuple_element_t<I - 1, List>;
+                    return value ? CppToJs<T>::convert(env, *static_cast<const T*>(value)) : env.Null();
+                }
+            }
+        };
+
+        static Napi::Value convert(const Napi::Env& env, const U& value)
+        {
+            static constexpr auto kConverters = TaggedUnion::makeTable<Entry>(std::make_index_sequence<kCount>{});
+            auto tag = static_cast<uint32_t>(value.type);
+            return TaggedUnion::make(env, tag, tag < kCount ? kConverters[tag](env, value.value) : env.Null());
+        }
+    };
+
     //
     // type conversion : js => c++
     //
@@ -200,7 +356,24 @@ namespace TypeConversion
         static T convert(const Napi::Value& value)
         {
             if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>)
-                return static_cast<T>(value.As<Napi::Number>().Uint32Value());
+            {
+                // the ts object api uses bigint for 64 bit fields
+                if (value.IsBigInt())
+                {
+                    bool lossless = false;
+                    T result;
+                    if constexpr (std::is_same_v<T, int64_t>)
+                        result = value.As<Napi::BigInt>().Int64Value(&lossless);
+                    else
+                        result = value.As<Napi::BigInt>().Uint64Value(&lossless);
+                    // truncated silently otherwise
+                    if (!lossless)
+                        throw Napi::RangeError::New(value.Env(), std::is_same_v<T, int64_t>
+                            ? "bigint out of the int64 range" : "bigint out of the uint64 range");
+                    return result;
+                }
+                return static_cast<T>(value.As<Napi::Number>().Int64Value());
+            }
             else if constexpr (std::is_same_v<T, bool>)
                 return value.As<Napi::Boolean>().Value();
             else
@@ -245,6 +418,15 @@ namespace TypeConversion
         }
     };
 
+    template<>
+    struct JsToCpp<ScratchString>
+    {
+        static ScratchString convert(const Napi::Value& value)
+        {
+            return ScratchString(value);
+        }
+    };
+
     template<class Ret, class ... Args>
     struct JsToCpp<std::function<Ret(Args...)>>
     {
@@ -263,6 +445,15 @@ namespace TypeConversion
         }
     };
 
+    template<class T>
+    struct JsToCpp<Napi::Buffer<T>>
+    {
+        static Napi::Buffer<T> convert(const Napi::Value& value)
+        {
+            return value.As<Napi::Buffer<T>>();
+        }
+    };
+
     template<class T, class Alloc>
     struct JsToCpp<std::vector<T, Alloc>>
     {
@@ -273,8 +464,12 @@ namespace TypeConversion
 
             std::vector<T, Alloc> result;
             Napi::Array arr = value.As<Napi::Array>();
-            for (uint32_t i = 0; i < arr.Length(); ++i)
+            uint32_t length = arr.Length();
+            result.reserve(length);
+            ChunkedHandleScope scope(value.Env(), length);
+            for (uint32_t i = 0; i < length; ++i)
             {
+                scope.next();
                 Napi::Value element = arr[i];
                 result.push_back(JsToCpp<T>::convert(element));
             }
@@ -282,21 +477,200 @@ namespace TypeConversion
         }
     };
 
-    template<class T>
-    struct JsToCpp<std::unordered_set<T>>
+    // from an array or a Set
+    template<class Set>
+    struct JsToCppSet
     {
-        static std::unordered_set<T> convert(const Napi::Value& value)
+        static Set convert(const Napi::Value& value)
         {
             if (value.IsNull() || value.IsUndefined())
                 return {};
 
-            std::unordered_set<T> result;
-            Napi::Array arr = value.As<Napi::Array>();
-            for (uint32_t i = 0; i < arr.Length(); ++i)
+            Set result;
+            bool isSet = JsCollections::isSet(value);
+            Napi::Array arr = isSet ? JsCollections::values(value) : value.As<Napi::Array>();
+            uint32_t length = arr.Length();
+            if constexpr (std::is_same_v<Set, std::unordered_set<typename Set::value_type>>)
+                result.reserve(length);
+            ChunkedHandleScope scope(value.Env(), length);
+            for (uint32_t i = 0; i < length; ++i)
             {
+                scope.next();
                 Napi::Value element = arr[i];
-                result.insert(JsToCpp<T>::convert(element));
+                // TypeCheck only looked at the Set itself
+                if (isSet && !TypeCheck<typename Set::value_type>::check(element))
+                    throw Napi::TypeError::New(value.Env(), "set element " + std::to_string(i) + " has a wrong type");
+                result.insert(JsToCpp<typename Set::value_type>::convert(element));
+            }
+            return result;
+        }
+    };
+
+    template<class T>
+    struct JsToCpp<std::unordered_set<T>> : JsToCppSet<std::unordered_set<T>> {};
+
+    template<class T>
+    struct JsToCpp<std::set<T>> : JsToCppSet<std::set<T>> {};
+
+    // from a Map, or a plain object for integer keys
+    template<class Map>
+    struct JsToCppMap
+    {
+        using K = typename Map::key_type;
+        using V = typename Map::mapped_type;
+
+        static Map convert(const Napi::Value& value)
+        {
+            if (value.IsNull() || value.IsUndefined())
+                return {};
+
+            if constexpr (std::is_integral_v<K>)
+            {
+                if (!JsCollections::isMap(value))
+                    return fromObject(value.As<Napi::Object>());
             }
+
+            // TypeCheck only looked at the Map itself
+            auto entries = JsCollections::entries(value);
+            auto& keys = entries.first;
+            auto& values = entries.second;
+            return fill(value.Env(), keys.Length(),
+                [&keys](uint32_t i)
+                {
+                    Napi::Value key = keys.Get(i);
+                    if (!TypeCheck<K>::check(key))
+                        throw Napi::TypeError::New(key.Env(), "map key " + std::to_string(i) + " has a wrong type");
+                    return JsToCpp<K>::convert(key);
+                },
+                [&values](uint32_t i)
+                {
+                    Napi::Value value = values.Get(i);
+                    if (!TypeCheck<V>::check(value))
+                        throw Napi::TypeError::New(value.Env(), "map value " + std::to_string(i) + " has a wrong type");
+                    return value;
+                });
+        }
+
+    private:
+        static Map fromObject(const Napi::Object& object)
+        {
+            auto names = object.GetPropertyNames();
+            return fill(object.Env(), names.Length(),
+                [&names](uint32_t i)
+                {
+                    Napi::Value name = names[i];
+                    auto text = name.As<Napi::String>().Utf8Value();
+                    K key{};
+                    if (!JsCollections::parseKey(text, key))
+                        throw Napi::TypeError::New(name.Env(), "map key : " + text + " is not an integer");
+                    return key;
+                },
+                [&object, &names](uint32_t i) { return object.Get(names.Get(i)); });
+        }
+
+        template<class Key, class Value>
+        static Map fill(const Napi::Env& env, uint32_t length, const Key& key, const Value& value)
+        {
+            Map result;
+            if constexpr (std::is_same_v<Map, std::unordered_map<K, V>>)
+                result.reserve(length);
+            ChunkedHandleScope scope(env, length);
+            for (uint32_t i = 0; i < length; ++i)
+            {
+                scope.next();
+                result.emplace(key(i), JsToCpp<V>::convert(value(i)));
+            }
+            return result;
+        }
+    };
+
+    template<class K, class V>
+    struct JsToCpp<std::unordered_map<K, V>> : JsToCppMap<std::unordered_map<K, V>> {};
+
+    template<class K, class V>
+    struct JsToCpp<std::map<K, V>> : JsToCppMap<std::map<K, V>> {};
+
+    template<class T>
+    struct JsToCpp<std::unique_ptr<T>>
+    {
+        static std::unique_ptr<T> convert(const Napi::Value& value)
+        {
+            if (value.IsUndefined() || value.IsNull())
+                return nullptr;
+            else
+                return std::make_unique<T>(JsToCpp<T>::convert(value));
+        }
+    };
+
+    template<>
+    struct JsToCpp<std::monostate>
+    {
+        static std::monostate convert(const Napi::Value&)
+        {
+            return {};
+        }
+    };
+
+    template<class ... Ts>
+    struct JsToCpp<std::variant<Ts...>>
+    {
+        using Variant = std::variant<Ts...>;
+
+        template<std::size_t I>
+        struct Entry
+        {
+            static Variant call(const Napi::Value& value)
+            {
+                return Variant(std::in_place_index<I>, JsToCpp<std::variant_alternative_t<I, Variant>>::convert(value));
+            }
+        };
+
+        static Variant convert(const Napi::Value& value)
+        {
+            static constexpr auto kConverters = TaggedUnion::makeTable<Entry>(std::index_sequence_for<Ts...>{});
+            auto index = TaggedUnion::typeOf(value, sizeof...(Ts));
+            if (index == sizeof...(Ts))
+                throw Napi::TypeError::New(value.Env(), "expected a { type, value } object with a valid type");
+
+            return kConverters[index](value.As<Napi::Object>().Get(TaggedUnion::kValue));
+        }
+    };
+
+    template<class U>
+    struct JsToCpp<U, std::enable_if_t<TaggedUnion::isUnion<U>>>
+    {
+        using List = typename TaggedUnion::Types<U>::List;
+        static constexpr uint32_t kCount = std::tuple_size_v<List> + 1;
+
+        // the union owns the table, as with the generated UnPack
+        template<std::size_t I>
+        struct Entry
+        {
+            static void* call(const Napi::Value& value)
+            {
+                if constexpr (I == 0)
+                    return nullptr;
+                else
+                {
+                    using T = std::tuple_element_t<I - 1, List>;
+                    return new T(JsToCpp<T>::convert(value));
+                }
+            }
+        };
+
+        static U convert(const Napi::Value& value)
+        {
+            if (value.IsNull() || value.IsUndefined())
+                return {};
+
+            static constexpr auto kConverters = TaggedUnion::makeTable<Entry>(std::make_index_sequence<kCount>{});
+            auto tag = TaggedUnion::typeOf(value, kCount);
+            if (tag == kCount)
+                throw Napi::TypeError::New(value.Env(), "expected a { type, value } object with a valid union type");
+
+            U result;
+            result.value = kConverters[tag](value.As<Napi::Object>().Get(TaggedUnion::kValue));
+            result.type = static_cast<decltype(result.type)>(tag);
             return result;
         }
     };
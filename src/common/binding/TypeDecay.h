@@ -1,6 +1,10 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "ScratchString.h"
 
 template<class T, class Enable = void>
 struct TypeDecay
@@ -15,12 +19,22 @@ struct TypeDecay
 template<>
 struct TypeDecay<const char*>
 {
-    using Type = std::string;
-    static const char* forward(const std::string& input)
+    using Type = ScratchString;
+    static const char* forward(const ScratchString& input)
     {
         return input.c_str();
     }
 };
 
+template<class T>
+struct TypeDecay<T, std::enable_if_t<std::is_same_v<std::string_view, std::decay_t<T>>>>
+{
+    using Type = ScratchString;
+    static std::string_view forward(const ScratchString& input)
+    {
+        return input.view();
+    }
+};
+
 template<class T>
 using GetDecayType = typename TypeDecay<T>::Type;
\ No newline at end of file
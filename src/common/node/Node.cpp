@@ -1,10 +1,33 @@
 #include <cassert>
+#include <thread>
 
 #include "Node.h"
 
 namespace
 {
+    using Task = std::function<void(Napi::Env)>;
+
+    void runTask(Napi::Env env, Napi::Function, std::nullptr_t*, Task* task)
+    {
+        if (env != nullptr)
+        {
+            try
+            {
+                (*task)(env);
+            }
+            catch (const Napi::Error& error)
+            {
+                error.ThrowAsJavaScriptException();
+            }
+        }
+        delete task;
+    }
+
+    using TaskQueue = Napi::TypedThreadSafeFunction<std::nullptr_t, Task, runTask>;
+
     Napi::Env NodeEnv = nullptr;
+    std::thread::id JsThread;
+    TaskQueue Tasks;
 }
 
 void Node::setEnv(Napi::Env env)
@@ -15,9 +38,32 @@ void Node::setEnv(Napi::Env env)
     assert(r == napi_ok);
 
     NodeEnv = env;
+    JsThread = std::this_thread::get_id();
+
+    // does not keep the process alive on its own
+    Tasks = TaskQueue::New(env, "NodeTasks", 0, 1);
+    Tasks.Unref(env);
 }
 
 Napi::Env Node::getEnv()
 {
     return NodeEnv;
-}
\ No newline at end of file
+}
+
+bool Node::isJsThread()
+{
+    return std::this_thread::get_id() == JsThread;
+}
+
+void Node::runOnJsThread(std::function<void(Napi::Env)> task)
+{
+    if (isJsThread())
+    {
+        task(NodeEnv);
+        return;
+    }
+
+    auto queued = new Task(std::move(task));
+    if (Tasks.NonBlockingCall(queued) != napi_ok)
+        delete queued;
+}
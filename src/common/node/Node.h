@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 #include <napi.h>
 
 class Node
@@ -7,4 +9,8 @@ class Node
 public:
     static void setEnv(Napi::Env env);
     static Napi::Env getEnv();
+    // the thread running js, the one the addon was loaded on
+    static bool isJsThread();
+    // runs `task` on the js thread : right away when called from it, else queued to the event loop
+    static void runOnJsThread(std::function<void(Napi::Env)> task);
 };
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "SchemaRegistry.h"
+#include "ColumnDecoder.h"
+
+namespace
+{
+    struct Column
+    {
+        std::string name;
+        reflection::BaseType type;
+        uint32_t offset;
+        size_t size;
+        uint8_t* data;
+    };
+
+    void collectColumns(
+        const SchemaRegistry::Type& type, const std::string& prefix, uint32_t baseOffset, std::vector<Column>& columns)
+    {
+        std::vector<const reflection::Field*> fields(type.object->fields()->begin(), type.object->fields()->end());
+        std::sort(fields.begin(), fields.end(), [](auto a, auto b) { return a->offset() < b->offset(); });
+
+        for (auto field : fields)
+        {
+            auto name = prefix + field->name()->str();
+            auto fieldType = field->type();
+            auto offset = baseOffset + field->offset();
+
+            switch (fieldType->base_type())
+            {
+            case reflection::Obj:
+                collectColumns(SchemaRegistry::resolve(type.schema, fieldType), name + ".", offset, columns);
+                break;
+            case reflection::Array:
+            {
+                auto element = fieldType->element();
+                if (element == reflection::Obj)
+                {
+                    auto elementType = SchemaRegistry::resolve(type.schema, fieldType);
+                    for (uint16_t i = 0; i < fieldType->fixed_length(); ++i)
+                        collectColumns(
+                            elementType, fmt::format("{}[{}].", name, i), offset + i * elementType.object->bytesize(), columns);
+                }
+                else
+                {
+                    auto size = flatbuffers::GetTypeSize(element);
+                    for (uint16_t i = 0; i < fieldType->fixed_length(); ++i)
+                        columns.push_back(
+                            { fmt::format("{}[{}]", name, i), element, static_cast<uint32_t>(offset + i * size), size, nullptr });
+                }
+                break;
+            }
+            default:
+                columns.push_back(
+                    { name, fieldType->base_type(), offset, flatbuffers::GetTypeSize(fieldType->base_type()), nullptr });
+                break;
+            }
+        }
+    }
+
+    template <class T>
+    Napi::Value createColumn(const Napi::Env& env, size_t length, uint8_t*& data)
+    {
+        auto array = Napi::TypedArrayOf<T>::New(env, length);
+        data = reinterpret_cast<uint8_t*>(array.Data());
+        return array;
+    }
+
+    Napi::Value createColumn(const Napi::Env& env, reflection::BaseType type, size_t length, uint8_t*& data)
+    {
+        switch (type)
+        {
+        case reflection::Bool:
+        case reflection::UByte: return createColumn<uint8_t>(env, length, data);
+        case reflection::Byte: return createColumn<int8_t>(env, length, data);
+        case reflection::Short: return createColumn<int16_t>(env, length, data);
+        case reflection::UShort: return createColumn<uint16_t>(env, length, data);
+        case reflection::Int: return createColumn<int32_t>(env, length, data);
+        case reflection::UInt: return createColumn<uint32_t>(env, length, data);
+        case reflection::Long: return createColumn<int64_t>(env, length, data);
+        case reflection::ULong: return createColumn<uint64_t>(env, length, data);
+        case reflection::Float: return createColumn<float>(env, length, data);
+        case reflection::Double: return createColumn<double>(env, length, data);
+        default:
+            throw std::runtime_error(
+                fmt::format("unsupported column type : {}", reflection::EnumNameBaseType(type)));
+        }
+    }
+
+    // flatbuffers are little endian, same as every platform we ship on, so a plain copy is enough
+    inline void copyScalar(uint8_t* dst, const uint8_t* src, size_t size)
+    {
+        switch (size)
+        {
+        case 1: *dst = *src; break;
+        case 2: std::memcpy(dst, src, 2); break;
+        case 4: std::memcpy(dst, src, 4); break;
+        case 8: std::memcpy(dst, src, 8); break;
+        }
+    }
+}
+
+Napi::Value ColumnDecoder::decode(Napi::Buffer<uint8_t> buffer, std::string rootType, std::string fieldPath)
+{
+    Napi::Env env = buffer.Env();
+
+    auto type = SchemaRegistry::instance()->find(rootType);
+    if (type.object->is_struct())
+        throw std::runtime_error(fmt::format("root type : {} is not a table", rootType));
+
+    // the walk below trusts every offset, the buffer is checked against the schema first
+    if (!flatbuffers::Verify(*type.schema, *type.object, buffer.Data(), buffer.Length()))
+        throw std::runtime_error(fmt::format("invalid flatbuffer for {}", rootType));
+
+    // walk the path down to the vector, a missing table on the way just gives empty columns
+    auto path = SchemaRegistry::splitPath(fieldPath);
+    const flatbuffers::Table* table = flatbuffers::GetAnyRoot(buffer.Data());
+    for (size_t i = 0; i + 1 < path.size(); ++i)
+    {
+        auto field = SchemaRegistry::findField(type.object, path[i]);
+        if (field->type()->base_type() != reflection::Obj)
+            throw std::runtime_error(fmt::format("field : {} is not a table", path[i]));
+
+        type = SchemaRegistry::resolve(type.schema, field->type());
+        if (type.object->is_struct())
+            throw std::runtime_error(fmt::format("field : {} is not a table", path[i]));
+
+        table = table ? flatbuffers::GetFieldT(*table, *field) : nullptr;
+    }
+
+    auto field = SchemaRegistry::findField(type.object, path.back());
+    if (field->type()->base_type() != reflection::Vector)
+        throw std::runtime_error(fmt::format("field : {} is not a vector", path.back()));
+
+    std::vector<Column> columns;
+    size_t stride = 0;
+    auto element = field->type()->element();
+    if (element == reflection::Obj)
+    {
+        auto elementType = SchemaRegistry::resolve(type.schema, field->type());
+        if (!elementType.object->is_struct())
+            throw std::runtime_error(fmt::format("field : {} is not a vector of structs", path.back()));
+
+        collectColumns(elementType, "", 0, columns);
+        stride = elementType.object->bytesize();
+    }
+    else if (flatbuffers::IsScalar(element))
+    {
+        stride = flatbuffers::GetTypeSize(element);
+        columns.push_back({ path.back(), element, 0, stride, nullptr });
+    }
+    else
+    {
+        throw std::runtime_error(fmt::format("field : {} is not a vector of structs or scalars", path.back()));
+    }
+
+    auto vector = table ? flatbuffers::GetFieldAnyV(*table, *field) : nullptr;
+    size_t length = vector ? vector->size() : 0;
+
+    Napi::Object result = Napi::Object::New(env);
+    for (auto& column : columns)
+        result.Set(column.name, createColumn(env, column.type, length, column.data));
+
+    const uint8_t* row = vector ? vector->Data() : nullptr;
+    for (size_t i = 0; i < length; ++i, row += stride)
+    {
+        for (auto& column : columns)
+            copyScalar(column.data + i * column.size, row + column.offset, column.size);
+    }
+
+    return result;
+}
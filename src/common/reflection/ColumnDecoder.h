@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+#include <napi.h>
+
+//
+// decodes a vector of structs (or scalars) inside a flatbuffer into struct-of-arrays :
+// { x : Float32Array, y : Float32Array, "pos.z" : Float64Array, ... }
+// one TypedArray per scalar field, filled in one pass over the vector, no per-row js object
+//
+class ColumnDecoder
+{
+public:
+    // fieldPath is a '.' separated list of table fields from the root table, the last one must be a vector
+    static Napi::Value decode(Napi::Buffer<uint8_t> buffer, std::string rootType, std::string fieldPath);
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//
+// schema typed value tree detached from js, so requests can be kept and edited off the js thread
+//
+struct DynamicValue
+{
+    enum class Kind
+    {
+        kNull,
+        kBool,
+        kInteger,
+        kReal,
+        kString,
+        kObject,
+        kVector
+    };
+
+    Kind kind = Kind::kNull;
+    int64_t integer = 0;
+    double real = 0;
+    std::string string;
+    std::map<std::string, DynamicValue> fields; // kObject, keyed by schema field name
+    std::vector<DynamicValue> elements;          // kVector
+
+    // sets a (possibly nested) field, missing intermediate objects are created
+    void set(const std::vector<std::string>& path, DynamicValue value)
+    {
+        auto current = this;
+        for (auto& name : path)
+        {
+            current->kind = Kind::kObject;
+            current = &current->fields[name];
+        }
+        *current = std::move(value);
+    }
+};
@@ -0,0 +1,289 @@
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <unordered_map>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "SchemaRegistry.h"
+#include "ObjectDecoder.h"
+
+namespace
+{
+    struct FieldLayout
+    {
+        const reflection::Field* field;
+        const reflection::Field* unionType;
+        SchemaRegistry::Type nested;
+        Napi::Reference<Napi::String> key;
+    };
+
+    struct TypeLayout
+    {
+        std::vector<FieldLayout> fields;
+
+        // key handles of the current decode call, fetched once per call from the persistent references
+        std::vector<napi_value> keys;
+        uint64_t generation = 0;
+    };
+
+    std::unordered_map<const reflection::Object*, TypeLayout> Layouts;
+    std::vector<napi_property_descriptor> Properties;
+    uint64_t Generation = 0;
+
+    constexpr auto PropertyAttributes = static_cast<napi_property_attributes>(napi_writable | napi_enumerable | napi_configurable);
+
+    TypeLayout& getLayout(const Napi::Env& env, const SchemaRegistry::Type& type)
+    {
+        auto it = Layouts.find(type.object);
+        if (it == Layouts.end())
+        {
+            std::vector<const reflection::Field*> fields;
+            for (auto field : *type.object->fields())
+            {
+                if (!field->deprecated())
+                    fields.push_back(field);
+            }
+
+            std::sort(fields.begin(), fields.end(), [](auto a, auto b) { return a->id() < b->id(); });
+
+            TypeLayout layout;
+            for (auto field : fields)
+            {
+                FieldLayout fieldLayout{ field, nullptr, {} };
+
+                auto fieldType = field->type();
+                auto baseType = fieldType->base_type();
+                if (baseType == reflection::Obj || ((baseType == reflection::Vector || baseType == reflection::Array) && fieldType->element() == reflection::Obj))
+                    fieldLayout.nested = SchemaRegistry::resolve(type.schema, fieldType);
+
+                if (baseType == reflection::Union)
+                    fieldLayout.unionType = type.object->fields()->LookupByKey((field->name()->str() + "_type").c_str());
+
+                fieldLayout.key = Napi::Persistent(Napi::String::New(env, SchemaRegistry::toCamelCase(field->name()->str())));
+                fieldLayout.key.SuppressDestruct();
+                layout.fields.push_back(std::move(fieldLayout));
+            }
+
+            it = Layouts.emplace(type.object, std::move(layout)).first;
+        }
+
+        auto& layout = it->second;
+        if (layout.generation != Generation)
+        {
+            layout.keys.clear();
+            for (auto& field : layout.fields)
+                layout.keys.push_back(field.key.Value());
+            layout.generation = Generation;
+        }
+        return layout;
+    }
+
+    Napi::Value integer(const Napi::Env& env, reflection::BaseType type, int64_t value)
+    {
+        switch (type)
+        {
+        case reflection::Bool: return Napi::Boolean::New(env, value != 0);
+        case reflection::Long: return Napi::BigInt::New(env, value);
+        case reflection::ULong: return Napi::BigInt::New(env, static_cast<uint64_t>(value));
+        default: return Napi::Number::New(env, static_cast<double>(value));
+        }
+    }
+
+    Napi::Value scalar(const Napi::Env& env, reflection::BaseType type, const uint8_t* data)
+    {
+        if (type == reflection::Float || type == reflection::Double)
+            return Napi::Number::New(env, flatbuffers::GetAnyValueF(type, data));
+        else
+            return integer(env, type, flatbuffers::GetAnyValueI(type, data));
+    }
+
+    Napi::Object defineObject(const Napi::Env& env, size_t base)
+    {
+        auto obj = Napi::Object::New(env);
+        auto status = napi_define_properties(env, obj, Properties.size() - base, Properties.data() + base);
+        Properties.resize(base);
+        if (status != napi_ok)
+            throw Napi::Error::New(env);
+        return obj;
+    }
+
+    void pushProperty(const TypeLayout& layout, size_t index, const Napi::Value& value)
+    {
+        Properties.push_back({ nullptr, layout.keys[index], nullptr, nullptr, nullptr, value, PropertyAttributes, nullptr });
+    }
+
+    Napi::Value decodeTable(const Napi::Env& env, const SchemaRegistry::Type& type, const flatbuffers::Table& table);
+
+    Napi::Value decodeStruct(const Napi::Env& env, const SchemaRegistry::Type& type, const uint8_t* data)
+    {
+        auto& layout = getLayout(env, type);
+        auto base = Properties.size();
+
+        for (size_t i = 0; i < layout.fields.size(); ++i)
+        {
+            auto& fieldLayout = layout.fields[i];
+            auto fieldType = fieldLayout.field->type();
+            auto fieldData = data + fieldLayout.field->offset();
+
+            Napi::Value value;
+            switch (fieldType->base_type())
+            {
+            case reflection::Obj:
+                value = decodeStruct(env, fieldLayout.nested, fieldData);
+                break;
+            case reflection::Array:
+            {
+                auto element = fieldType->element();
+                auto array = Napi::Array::New(env, fieldType->fixed_length());
+                for (uint32_t j = 0; j < fieldType->fixed_length(); ++j)
+                {
+                    if (element == reflection::Obj)
+                        array[j] = decodeStruct(env, fieldLayout.nested, fieldData + j * fieldLayout.nested.object->bytesize());
+                    else
+                        array[j] = scalar(env, element, fieldData + j * flatbuffers::GetTypeSize(element));
+                }
+                value = array;
+                break;
+            }
+            default:
+                value = scalar(env, fieldType->base_type(), fieldData);
+                break;
+            }
+            pushProperty(layout, i, value);
+        }
+
+        return defineObject(env, base);
+    }
+
+    Napi::Value decodeVector(const Napi::Env& env, const FieldLayout& fieldLayout, const flatbuffers::VectorOfAny* vector)
+    {
+        // the object api unpacks a missing vector to []
+        auto length = vector ? vector->size() : 0;
+        auto array = Napi::Array::New(env, length);
+        auto element = fieldLayout.field->type()->element();
+
+        for (uint32_t i = 0; i < length; ++i)
+        {
+            switch (element)
+            {
+            case reflection::String:
+            {
+                auto str = flatbuffers::GetAnyVectorElemPointer<const flatbuffers::String>(vector, i);
+                array[i] = Napi::String::New(env, str->c_str(), str->size());
+                break;
+            }
+            case reflection::Obj:
+                if (fieldLayout.nested.object->is_struct())
+                    array[i] = decodeStruct(env, fieldLayout.nested, vector->Data() + i * fieldLayout.nested.object->bytesize());
+                else
+                    array[i] = decodeTable(env, fieldLayout.nested, *flatbuffers::GetAnyVectorElemPointer<const flatbuffers::Table>(vector, i));
+                break;
+            case reflection::Float:
+            case reflection::Double:
+                array[i] = Napi::Number::New(env, flatbuffers::GetAnyVectorElemF(vector, element, i));
+                break;
+            case reflection::Union:
+                throw std::runtime_error(fmt::format("vector of unions is not supported : {}", fieldLayout.field->name()->str()));
+            default:
+                array[i] = integer(env, element, flatbuffers::GetAnyVectorElemI(vector, element, i));
+                break;
+            }
+        }
+        return array;
+    }
+
+    Napi::Value decodeUnion(
+        const Napi::Env& env, const SchemaRegistry::Type& owner, const FieldLayout& fieldLayout, const flatbuffers::Table& table)
+    {
+        if (!fieldLayout.unionType)
+            return env.Null();
+
+        auto enumDef = owner.schema->enums()->Get(fieldLayout.field->type()->index());
+        auto enumValue = enumDef->values()->LookupByKey(flatbuffers::GetAnyFieldI(table, *fieldLayout.unionType));
+        if (!enumValue || !enumValue->union_type() || enumValue->union_type()->base_type() != reflection::Obj)
+            return env.Null();
+
+        auto member = flatbuffers::GetFieldT(table, *fieldLayout.field);
+        if (!member)
+            return env.Null();
+
+        return decodeTable(env, SchemaRegistry::resolve(owner.schema, enumValue->union_type()), *member);
+    }
+
+    Napi::Value decodeTable(const Napi::Env& env, const SchemaRegistry::Type& type, const flatbuffers::Table& table)
+    {
+        auto& layout = getLayout(env, type);
+        auto base = Properties.size();
+
+        for (size_t i = 0; i < layout.fields.size(); ++i)
+        {
+            auto& fieldLayout = layout.fields[i];
+            auto& field = *fieldLayout.field;
+
+            // optional scalar (`= null` in the schema) : absent is unset, not its default
+            if (field.optional() && flatbuffers::IsScalar(field.type()->base_type()) && !table.CheckField(field.offset()))
+            {
+                pushProperty(layout, i, env.Null());
+                continue;
+            }
+
+            Napi::Value value;
+            switch (field.type()->base_type())
+            {
+            case reflection::Float:
+            case reflection::Double:
+                value = Napi::Number::New(env, flatbuffers::GetAnyFieldF(table, field));
+                break;
+            case reflection::String:
+            {
+                auto str = flatbuffers::GetFieldS(table, field);
+                value = str ? Napi::String::New(env, str->c_str(), str->size()) : env.Null();
+                break;
+            }
+            case reflection::Obj:
+                if (fieldLayout.nested.object->is_struct())
+                {
+                    auto data = flatbuffers::GetFieldStruct(table, field);
+                    value = data ? decodeStruct(env, fieldLayout.nested, reinterpret_cast<const uint8_t*>(data)) : env.Null();
+                }
+                else
+                {
+                    auto child = flatbuffers::GetFieldT(table, field);
+                    value = child ? decodeTable(env, fieldLayout.nested, *child) : env.Null();
+                }
+                break;
+            case reflection::Union:
+                value = decodeUnion(env, type, fieldLayout, table);
+                break;
+            case reflection::Vector:
+                value = decodeVector(env, fieldLayout, flatbuffers::GetFieldAnyV(table, field));
+                break;
+            default:
+                value = integer(env, field.type()->base_type(), flatbuffers::GetAnyFieldI(table, field));
+                break;
+            }
+            pushProperty(layout, i, value);
+        }
+
+        return defineObject(env, base);
+    }
+}
+
+Napi::Value ObjectDecoder::decode(Napi::Buffer<uint8_t> buffer, std::string rootType)
+{
+    Napi::Env env = buffer.Env();
+
+    auto type = SchemaRegistry::instance()->find(rootType);
+    if (type.object->is_struct())
+        throw std::runtime_error(fmt::format("root type : {} is not a table", rootType));
+
+    // decodeTable trusts every offset, the buffer is checked against the schema first
+    if (!flatbuffers::Verify(*type.schema, *type.object, buffer.Data(), buffer.Length()))
+        throw std::runtime_error(fmt::format("invalid flatbuffer for {}", rootType));
+
+    // a new generation invalidates the key handles cached by the previous call
+    ++Generation;
+    Properties.clear();
+    return decodeTable(env, type, *flatbuffers::GetAnyRoot(buffer.Data()));
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+#include <napi.h>
+
+//
+// schema driven flatbuffer => js decoder, produces the same objects as the ts object api (unpack())
+// property keys are created once per type and objects of the same type are defined with one
+// napi_define_properties call in a fixed order, so they share a single hidden class
+//
+class ObjectDecoder
+{
+public:
+    static Napi::Value decode(Napi::Buffer<uint8_t> buffer, std::string rootType);
+};
@@ -0,0 +1,368 @@
+#include <stdexcept>
+#include <type_traits>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "ObjectEncoder.h"
+
+namespace
+{
+    using Kind = DynamicValue::Kind;
+
+    DynamicValue fieldFromJs(
+        const SchemaRegistry::Type& owner, const reflection::Type* fieldType, reflection::BaseType baseType, const Napi::Value& value)
+    {
+        DynamicValue result;
+        switch (baseType)
+        {
+        case reflection::Bool:
+            result.kind = Kind::kBool;
+            result.integer = value.ToBoolean().Value() ? 1 : 0;
+            break;
+        case reflection::Float:
+        case reflection::Double:
+            result.kind = Kind::kReal;
+            result.real = value.ToNumber().DoubleValue();
+            break;
+        case reflection::String:
+            if (!value.IsString())
+                throw std::runtime_error("expect a string");
+            result.kind = Kind::kString;
+            result.string = value.As<Napi::String>().Utf8Value();
+            break;
+        case reflection::Obj:
+            result = ObjectEncoder::fromJs(SchemaRegistry::resolve(owner.schema, fieldType), value);
+            break;
+        case reflection::Vector:
+        {
+            if (!value.IsArray())
+                throw std::runtime_error("expect an array");
+
+            auto array = value.As<Napi::Array>();
+            result.kind = Kind::kVector;
+            result.elements.reserve(array.Length());
+            for (uint32_t i = 0; i < array.Length(); ++i)
+                result.elements.push_back(fieldFromJs(owner, fieldType, fieldType->element(), array.Get(i)));
+            break;
+        }
+        case reflection::Union:
+        case reflection::Array:
+            throw std::runtime_error(fmt::format("unsupported field type : {}", reflection::EnumNameBaseType(baseType)));
+        default:
+            result.kind = Kind::kInteger;
+            if (value.IsBigInt())
+            {
+                bool lossless = false;
+                result.integer = baseType == reflection::ULong ?
+                    static_cast<int64_t>(value.As<Napi::BigInt>().Uint64Value(&lossless)) : value.As<Napi::BigInt>().Int64Value(&lossless);
+            }
+            else
+            {
+                result.integer = value.ToNumber().Int64Value();
+            }
+            break;
+        }
+        return result;
+    }
+
+    int64_t toInteger(const DynamicValue& value)
+    {
+        switch (value.kind)
+        {
+        case Kind::kBool:
+        case Kind::kInteger: return value.integer;
+        case Kind::kReal: return static_cast<int64_t>(value.real);
+        default: throw std::runtime_error("expect a number");
+        }
+    }
+
+    double toReal(const DynamicValue& value)
+    {
+        return value.kind == Kind::kReal ? value.real : static_cast<double>(toInteger(value));
+    }
+
+    void writeScalar(uint8_t* data, reflection::BaseType type, const DynamicValue& value)
+    {
+        if (type == reflection::Float || type == reflection::Double)
+            flatbuffers::SetAnyValueF(type, data, toReal(value));
+        else
+            flatbuffers::SetAnyValueI(type, data, toInteger(value));
+    }
+
+    template <class T>
+    void addScalar(flatbuffers::FlatBufferBuilder& builder, const reflection::Field* field, const DynamicValue& value)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+            builder.AddElement<T>(field->offset(), static_cast<T>(toReal(value)), static_cast<T>(field->default_real()));
+        else
+            builder.AddElement<T>(field->offset(), static_cast<T>(toInteger(value)), static_cast<T>(field->default_integer()));
+    }
+
+    void addScalar(flatbuffers::FlatBufferBuilder& builder, const reflection::Field* field, const DynamicValue& value)
+    {
+        switch (field->type()->base_type())
+        {
+        case reflection::Bool:
+        case reflection::UType:
+        case reflection::UByte: addScalar<uint8_t>(builder, field, value); break;
+        case reflection::Byte: addScalar<int8_t>(builder, field, value); break;
+        case reflection::Short: addScalar<int16_t>(builder, field, value); break;
+        case reflection::UShort: addScalar<uint16_t>(builder, field, value); break;
+        case reflection::Int: addScalar<int32_t>(builder, field, value); break;
+        case reflection::UInt: addScalar<uint32_t>(builder, field, value); break;
+        case reflection::Long: addScalar<int64_t>(builder, field, value); break;
+        case reflection::ULong: addScalar<uint64_t>(builder, field, value); break;
+        case reflection::Float: addScalar<float>(builder, field, value); break;
+        case reflection::Double: addScalar<double>(builder, field, value); break;
+        default: break;
+        }
+    }
+
+    void buildStruct(const SchemaRegistry::Type& type, const DynamicValue& value, uint8_t* data)
+    {
+        for (auto& [name, member] : value.fields)
+        {
+            auto field = SchemaRegistry::findField(type.object, name);
+            auto baseType = field->type()->base_type();
+            if (baseType == reflection::Obj)
+                buildStruct(SchemaRegistry::resolve(type.schema, field->type()), member, data + field->offset());
+            else if (flatbuffers::IsScalar(baseType))
+                writeScalar(data + field->offset(), baseType, member);
+        }
+    }
+
+    flatbuffers::uoffset_t buildTable(flatbuffers::FlatBufferBuilder& builder, const SchemaRegistry::Type& type, const DynamicValue& value);
+
+    flatbuffers::uoffset_t buildVector(
+        flatbuffers::FlatBufferBuilder& builder, const SchemaRegistry::Type& owner, const reflection::Field* field, const DynamicValue& value)
+    {
+        if (value.kind != Kind::kVector)
+            throw std::runtime_error(fmt::format("field : {} expects an array", field->name()->str()));
+
+        auto& elements = value.elements;
+        auto element = field->type()->element();
+        if (element == reflection::String || (element == reflection::Obj && !SchemaRegistry::resolve(owner.schema, field->type()).object->is_struct()))
+        {
+            // children have to be finished before the vector starts
+            std::vector<flatbuffers::Offset<void>> offsets;
+            offsets.reserve(elements.size());
+            for (auto& item : elements)
+            {
+                if (element == reflection::String)
+                    offsets.push_back(builder.CreateString(item.string).o);
+                else
+                    offsets.push_back(buildTable(builder, SchemaRegistry::resolve(owner.schema, field->type()), item));
+            }
+            return builder.CreateVector(offsets).o;
+        }
+
+        size_t size = 0;
+        size_t alignment = 0;
+        std::vector<uint8_t> bytes;
+        if (element == reflection::Obj)
+        {
+            auto elementType = SchemaRegistry::resolve(owner.schema, field->type());
+            size = elementType.object->bytesize();
+            alignment = elementType.object->minalign();
+            bytes.resize(size * elements.size());
+            for (size_t i = 0; i < elements.size(); ++i)
+                buildStruct(elementType, elements[i], bytes.data() + i * size);
+        }
+        else
+        {
+            size = alignment = flatbuffers::GetTypeSize(element);
+            bytes.resize(size * elements.size());
+            for (size_t i = 0; i < elements.size(); ++i)
+                writeScalar(bytes.data() + i * size, element, elements[i]);
+        }
+
+        // same trick as CreateVectorOfStructs : struct sizes are not always a power of 2, their alignment is
+        builder.StartVector(bytes.size() / alignment, alignment);
+        builder.PushBytes(bytes.data(), bytes.size());
+        return builder.EndVector(elements.size());
+    }
+
+    flatbuffers::uoffset_t buildTable(flatbuffers::FlatBufferBuilder& builder, const SchemaRegistry::Type& type, const DynamicValue& value)
+    {
+        if (value.kind != Kind::kObject)
+            throw std::runtime_error(fmt::format("type : {} expects an object", type.object->name()->str()));
+
+        std::vector<std::pair<const reflection::Field*, flatbuffers::uoffset_t>> offsets;
+        for (auto& [name, member] : value.fields)
+        {
+            if (member.kind == Kind::kNull)
+                continue;
+
+            auto field = SchemaRegistry::findField(type.object, name);
+            switch (field->type()->base_type())
+            {
+            case reflection::String:
+                if (member.kind != Kind::kString)
+                    throw std::runtime_error(fmt::format("field : {} expects a string", name));
+                offsets.emplace_back(field, builder.CreateString(member.string).o);
+                break;
+            case reflection::Vector:
+                offsets.emplace_back(field, buildVector(builder, type, field, member));
+                break;
+            case reflection::Obj:
+            {
+                auto fieldType = SchemaRegistry::resolve(type.schema, field->type());
+                if (!fieldType.object->is_struct())
+                    offsets.emplace_back(field, buildTable(builder, fieldType, member));
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        auto start = builder.StartTable();
+        for (auto& [field, offset] : offsets)
+            builder.AddOffset(field->offset(), flatbuffers::Offset<void>(offset));
+
+        for (auto& [name, member] : value.fields)
+        {
+            if (member.kind == Kind::kNull)
+                continue;
+
+            auto field = SchemaRegistry::findField(type.object, name);
+            auto baseType = field->type()->base_type();
+            if (flatbuffers::IsScalar(baseType))
+            {
+                addScalar(builder, field, member);
+            }
+            else if (baseType == reflection::Obj)
+            {
+                auto fieldType = SchemaRegistry::resolve(type.schema, field->type());
+                if (fieldType.object->is_struct())
+                {
+                    std::vector<uint8_t> bytes(fieldType.object->bytesize());
+                    buildStruct(fieldType, member, bytes.data());
+                    builder.Align(fieldType.object->minalign());
+                    builder.PushBytes(bytes.data(), bytes.size());
+                    builder.TrackField(field->offset(), builder.GetSize());
+                }
+            }
+        }
+        return builder.EndTable(start);
+    }
+}
+
+DynamicValue ObjectEncoder::fromJs(const SchemaRegistry::Type& type, const Napi::Value& value)
+{
+    if (!value.IsObject())
+        throw std::runtime_error(fmt::format("type : {} expects an object", type.object->name()->str()));
+
+    auto obj = value.As<Napi::Object>();
+    DynamicValue result;
+    result.kind = Kind::kObject;
+    for (auto field : *type.object->fields())
+    {
+        if (field->deprecated() || field->type()->base_type() == reflection::UType)
+            continue;
+
+        auto name = field->name()->str();
+        Napi::Value member = obj.Get(SchemaRegistry::toCamelCase(name));
+        if (member.IsUndefined())
+            member = obj.Get(name);
+
+        if (member.IsUndefined() || member.IsNull())
+            continue;
+
+        try
+        {
+            result.fields[name] = fieldFromJs(type, field->type(), field->type()->base_type(), member);
+        }
+        catch (const std::runtime_error& e)
+        {
+            throw std::runtime_error(fmt::format("{}.{} : {}", type.object->name()->str(), name, e.what()));
+        }
+    }
+    return result;
+}
+
+void ObjectEncoder::build(flatbuffers::FlatBufferBuilder& builder, const SchemaRegistry::Type& type, const DynamicValue& value)
+{
+    if (type.object->is_struct())
+        throw std::runtime_error(fmt::format("root type : {} is not a table", type.object->name()->str()));
+
+    builder.Finish(flatbuffers::Offset<void>(buildTable(builder, type, value)));
+}
+
+ObjectEncoder::FieldPath ObjectEncoder::resolvePath(const SchemaRegistry::Type& type, const std::vector<std::string>& path)
+{
+    FieldPath result{ type };
+    auto current = type;
+    for (size_t i = 0; i + 1 < path.size(); ++i)
+    {
+        auto field = SchemaRegistry::findField(current.object, path[i]);
+        if (field->type()->base_type() != reflection::Obj)
+            throw std::runtime_error(fmt::format("field : {} is not a table", path[i]));
+
+        current = SchemaRegistry::resolve(current.schema, field->type());
+        if (current.object->is_struct())
+            throw std::runtime_error(fmt::format("field : {} is not a table", path[i]));
+        result.fields.push_back(field);
+    }
+
+    auto field = SchemaRegistry::findField(current.object, path.back());
+    auto baseType = field->type()->base_type();
+    if (!flatbuffers::IsScalar(baseType) && baseType != reflection::String)
+        throw std::runtime_error(fmt::format("field : {} is not a scalar or a string", path.back()));
+
+    result.fields.push_back(field);
+    return result;
+}
+
+const reflection::Field* ObjectEncoder::findPath(const SchemaRegistry::Type& type, const std::vector<std::string>& path)
+{
+    return resolvePath(type, path).fields.back();
+}
+
+DynamicValue ObjectEncoder::readField(const FieldPath& path, const uint8_t* buffer, size_t length)
+{
+    // the payloads come from the network, nothing is read before the offsets are known to be in bounds
+    if (!flatbuffers::Verify(*path.root.schema, *path.root.object, buffer, length))
+        throw std::runtime_error(fmt::format("invalid flatbuffer for {}", path.root.object->name()->str()));
+
+    DynamicValue result;
+    auto field = path.fields.back();
+    const flatbuffers::Table* table = flatbuffers::GetAnyRoot(buffer);
+    for (size_t i = 0; i + 1 < path.fields.size() && table; ++i)
+        table = flatbuffers::GetFieldT(*table, *path.fields[i]);
+
+    if (!table)
+        throw std::runtime_error(fmt::format("a table on the path of field : {} is missing", field->name()->str()));
+
+    switch (field->type()->base_type())
+    {
+    case reflection::String:
+        if (auto str = flatbuffers::GetFieldS(*table, *field))
+        {
+            result.kind = Kind::kString;
+            result.string = str->str();
+        }
+        break;
+    case reflection::Float:
+    case reflection::Double:
+        result.kind = Kind::kReal;
+        result.real = flatbuffers::GetAnyFieldF(*table, *field);
+        break;
+    default:
+        result.kind = field->type()->base_type() == reflection::Bool ? Kind::kBool : Kind::kInteger;
+        result.integer = flatbuffers::GetAnyFieldI(*table, *field);
+        break;
+    }
+    return result;
+}
+
+Napi::Value ObjectEncoder::encode(Napi::Value value, std::string rootType)
+{
+    auto type = SchemaRegistry::instance()->find(rootType);
+
+    // Clear() keeps the memory of the previous request
+    static flatbuffers::FlatBufferBuilder builder;
+    builder.Clear();
+    build(builder, type, fromJs(type, value));
+    return Napi::Buffer<uint8_t>::Copy(value.Env(), builder.GetBufferPointer(), builder.GetSize());
+}
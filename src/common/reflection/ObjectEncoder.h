@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <napi.h>
+#include <flatbuffers/flatbuffers.h>
+
+#include "SchemaRegistry.h"
+#include "DynamicValue.h"
+
+//
+// schema driven js => flatbuffer encoder, counterpart of ObjectDecoder
+// js objects are first copied into a DynamicValue (js thread only), which can then be built on any thread
+//
+class ObjectEncoder
+{
+public:
+    // accepts ts object api names (objectId) as well as schema names (object_id), unions are not supported
+    static DynamicValue fromJs(const SchemaRegistry::Type& type, const Napi::Value& value);
+
+    static void build(flatbuffers::FlatBufferBuilder& builder, const SchemaRegistry::Type& type, const DynamicValue& value);
+
+    // a field path resolved once, then read from any thread
+    struct FieldPath
+    {
+        SchemaRegistry::Type root;
+        std::vector<const reflection::Field*> fields; // the tables on the way, then the scalar or string field
+    };
+
+    // walks a table path, the last field must be a scalar or a string
+    static FieldPath resolvePath(const SchemaRegistry::Type& type, const std::vector<std::string>& path);
+    static const reflection::Field* findPath(const SchemaRegistry::Type& type, const std::vector<std::string>& path);
+
+    // verifies `buffer` against the root type, then reads the field : absent scalars give their default value,
+    // an absent string kNull. throws on an invalid buffer or a missing table on the way
+    static DynamicValue readField(const FieldPath& path, const uint8_t* buffer, size_t length);
+
+    static Napi::Value encode(Napi::Value value, std::string rootType);
+};
@@ -0,0 +1,121 @@
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "SchemaRegistry.h"
+
+void SchemaRegistry::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        throw std::runtime_error(fmt::format("can't open schema file : {}", path));
+
+    auto length = static_cast<size_t>(file.tellg());
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[length]);
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(buffer.get()), length))
+        throw std::runtime_error(fmt::format("can't read schema file : {}", path));
+
+    flatbuffers::Verifier verifier(buffer.get(), length);
+    if (!reflection::VerifySchemaBuffer(verifier))
+        throw std::runtime_error(fmt::format("invalid schema file : {}", path));
+
+    auto schema = reflection::GetSchema(buffer.get());
+    for (auto object : *schema->objects())
+        addObject(schema, object);
+    if (schema->services())
+    {
+        for (auto service : *schema->services())
+            addService(schema, service);
+    }
+
+    m_buffers.push_back(std::move(buffer));
+}
+
+SchemaRegistry::Type SchemaRegistry::find(const std::string& name) const
+{
+    auto it = m_types.find(name);
+    if (it == m_types.end())
+        throw std::runtime_error(fmt::format("can't find type : {}, is the schema loaded?", name));
+
+    return it->second;
+}
+
+SchemaRegistry::Call SchemaRegistry::findCall(const std::string& name) const
+{
+    auto it = m_calls.find(name);
+    if (it == m_calls.end())
+        throw std::runtime_error(fmt::format("can't find rpc call : {}, is the schema loaded?", name));
+
+    return it->second;
+}
+
+void SchemaRegistry::addService(const reflection::Schema* schema, const reflection::Service* service)
+{
+    std::string serviceName = service->name()->str();
+    auto pos = serviceName.rfind('.');
+    std::string shortName = pos == std::string::npos ? serviceName : serviceName.substr(pos + 1);
+
+    for (auto call : *service->calls())
+    {
+        Call resolved{ { schema, call->request() }, { schema, call->response() } };
+        std::string callName = call->name()->str();
+        std::string bound = callName;
+        bound[0] = static_cast<char>(::tolower(bound[0]));
+
+        for (auto& name : { callName, bound })
+        {
+            m_calls[serviceName + "." + name] = resolved;
+            m_calls.emplace(shortName + "." + name, resolved);
+        }
+    }
+}
+
+void SchemaRegistry::addObject(const reflection::Schema* schema, const reflection::Object* object)
+{
+    std::string fullName = object->name()->str();
+    m_types[fullName] = { schema, object };
+
+    // every .bfbs carries its included types as well, so the first short name wins
+    auto pos = fullName.rfind('.');
+    if (pos != std::string::npos)
+        m_types.emplace(fullName.substr(pos + 1), Type{ schema, object });
+}
+
+const reflection::Field* SchemaRegistry::findField(const reflection::Object* object, const std::string& name)
+{
+    auto field = object->fields()->LookupByKey(name.c_str());
+    if (!field)
+        throw std::runtime_error(fmt::format("can't find field : {} in type : {}", name, object->name()->str()));
+    return field;
+}
+
+std::vector<std::string> SchemaRegistry::splitPath(const std::string& path)
+{
+    std::vector<std::string> result;
+    size_t begin = 0;
+    while (begin <= path.size())
+    {
+        auto end = path.find('.', begin);
+        if (end == std::string::npos)
+            end = path.size();
+        result.push_back(path.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return result;
+}
+
+std::string SchemaRegistry::toCamelCase(const std::string& name)
+{
+    std::string result;
+    for (size_t i = 0; i < name.size(); ++i)
+    {
+        if (name[i] == '_' && i + 1 < name.size())
+            result += static_cast<char>(::toupper(name[++i]));
+        else
+            result += name[i];
+    }
+    return result;
+}
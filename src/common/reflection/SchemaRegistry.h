@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <flatbuffers/reflection.h>
+
+#include "common/utils/Singleton.h"
+
+//
+// keeps compiled schemas (.bfbs, generated by flatc from PROTO_ROOT) alive
+// and resolves table / struct types by name for the native decoders, and rpc calls to their table types
+//
+class SchemaRegistry : public Singleton<SchemaRegistry>
+{
+public:
+    struct Type
+    {
+        const reflection::Schema* schema = nullptr;
+        const reflection::Object* object = nullptr;
+    };
+
+    struct Call
+    {
+        Type request;
+        Type response;
+    };
+
+    static void loadSchema(std::string path)
+    {
+        instance()->load(path);
+    }
+
+    void load(const std::string& path);
+
+    // accepts fully qualified names (eg : fbrpc.test.HelloWorldResponse) and short names
+    Type find(const std::string& name) const;
+
+    // rpc_service calls by Service.call, the call name also in lower camel case as bound (eg : ExampleAPI.helloWorld)
+    Call findCall(const std::string& name) const;
+
+    static Type resolve(const reflection::Schema* schema, const reflection::Type* type)
+    {
+        return { schema, schema->objects()->Get(type->index()) };
+    }
+
+    static const reflection::Field* findField(const reflection::Object* object, const std::string& name);
+
+    // '.' separated field path => field names
+    static std::vector<std::string> splitPath(const std::string& path);
+
+    // same naming as the ts object api : object_id => objectId
+    static std::string toCamelCase(const std::string& name);
+
+private:
+    void addObject(const reflection::Schema* schema, const reflection::Object* object);
+    void addService(const reflection::Schema* schema, const reflection::Service* service);
+
+    std::vector<std::unique_ptr<uint8_t[]>> m_buffers;
+    std::unordered_map<std::string, Type> m_types;
+    std::unordered_map<std::string, Call> m_calls;
+};
@@ -0,0 +1,26 @@
+#include <new>
+#include <cstdlib>
+
+#include "AllocationCounter.h"
+
+#ifdef FBRPC_COUNT_ALLOCATIONS
+
+void* operator new(std::size_t size)
+{
+    ++AllocationCounter::current();
+    if (auto memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+//
+// per thread count of operator new calls, only maintained when built with FBRPC_COUNT_ALLOCATIONS
+// (the replacement operators live in AllocationCounter.cpp), used to keep hot paths allocation free
+//
+class AllocationCounter
+{
+public:
+#ifdef FBRPC_COUNT_ALLOCATIONS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    static uint64_t& current()
+    {
+        thread_local uint64_t count = 0;
+        return count;
+    }
+
+    // adds the allocations made by the current thread during its lifetime to `total`
+    class Scope
+    {
+    public:
+        Scope(std::atomic<uint64_t>& total) : m_total(total), m_start(current()) {}
+        ~Scope() { m_total.fetch_add(current() - m_start, std::memory_order_relaxed); }
+    private:
+        std::atomic<uint64_t>& m_total;
+        uint64_t m_start;
+    };
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+//
+// lets producer threads use a resource until another thread closes it, close() waits for the uses in progress
+// so the resource can be released right after, without a lock on the producer side
+//
+class UseGuard
+{
+public:
+    bool enter()
+    {
+        m_users.fetch_add(1);
+        if (m_closed.load())
+        {
+            leave();
+            return false;
+        }
+        return true;
+    }
+
+    void leave()
+    {
+        m_users.fetch_sub(1);
+    }
+
+    // true for the first close only
+    bool close()
+    {
+        if (m_closed.exchange(true))
+            return false;
+        while (m_users.load() != 0)
+            std::this_thread::yield();
+        return true;
+    }
+
+    bool closed() const
+    {
+        return m_closed.load();
+    }
+
+private:
+    std::atomic<bool> m_closed{ false };
+    std::atomic<int> m_users{ 0 };
+};
@@ -1,12 +1,86 @@
 #include "generated/FlatBufferRpcBinding_generated.h"
+#include "common/reflection/SchemaRegistry.h"
+#include "common/reflection/ColumnDecoder.h"
+#include "common/reflection/ObjectDecoder.h"
+#include "common/reflection/ObjectEncoder.h"
+#include "rpc/RpcPipeline.h"
+#include "rpc/PayloadCodec.h"
+#include "rpc/ConcurrencyLimiter.h"
+#include "rpc/ShardedClient.h"
+#include "rpc/TrafficCapture.h"
+#include "rpc/EventConflator.h"
+#include "rpc/ConnectionManager.h"
+#include "common/utils/Timer.h"
 
 Napi::Object init(Napi::Env env, Napi::Object exports)
 {
+	Timer timer;
 	Node::setEnv(env);
 
 	BindingHelper helper(env, exports);
 	helper.addGlobalFunction<FlatbufferClient::connect>("connect");
+	helper.addGlobalFunction<FlatbufferClient::metrics>("metrics");
+
+	helper.begin("Reflection")
+		.addStaticFunction<SchemaRegistry::loadSchema>("loadSchema")
+		.addStaticFunction<ObjectDecoder::decode>("decode")
+		.addStaticFunction<ColumnDecoder::decode>("decodeColumns")
+		.addStaticFunction<ObjectEncoder::encode>("encode")
+		.end();
+
+	helper.begin("Pipeline")
+		.addStaticFunction<RpcPipeline::run>("run")
+		.end();
+
+	helper.begin("Compression")
+		.addStaticFunction<PayloadCodec::configure>("configure")
+		.addStaticFunction<PayloadCodec::metrics>("metrics")
+		.addStaticFunction<PayloadCodec::compress>("compress")
+		.addStaticFunction<PayloadCodec::decompress>("decompress")
+		.end();
+
+	helper.begin("Sharding")
+		.addStaticFunction<ShardedClient::connect>("connect")
+		.addStaticFunction<ShardedClient::shardOf>("shardOf")
+		.end();
+
+	helper.begin("Capture")
+		.addStaticFunction<TrafficCapture::start>("start")
+		.addStaticFunction<TrafficCapture::stop>("stop")
+		.addStaticFunction<TrafficCapture::replay>("replay")
+		.end();
+
+	helper.begin("Reconnect")
+		.addStaticFunction<ConnectionManager::configure>("configure")
+		.addStaticFunction<ConnectionManager::status>("status")
+		.end();
+
+	helper.begin("Limiter")
+		.addStaticFunction<ConcurrencyLimiter::configure>("configure")
+		.addStaticFunction<ConcurrencyLimiter::status>("status")
+		.end();
+
+	helper.begin("Subscriptions")
+		.addStaticFunction<Subscription::create>("create")
+		.addStaticFunction<Subscription::conflate>("conflate")
+		.addStaticFunction<Subscription::count>("count")
+		.end();
+
+	helper.begin("Diagnostics")
+		.addStaticFunction<CallbackWrapper::statistics>("callbacks")
+		.addStaticFunction<HandleCounter::report>("handles")
+		.addStaticFunction<LazyBindingStats::report>("startup")
+		.addStaticFunction<BufferPool::report>("buffers")
+		.addStaticFunction<EventConflator::statistics>("conflation")
+		.addStaticFunction<ResolverStats::report>("resolvers")
+		.end();
+
+	// the generated services also become RpcMethods, for Pipeline, Sharding and the reconnect journal
+	helper.intercept(ServiceCall::bind);
 	FlatBufferBinding::bind(helper);
+	helper.intercept(nullptr);
+
+	LazyBindingStats::get().initMs = timer.delta() * 1000.0;
 
 	return exports;
 }
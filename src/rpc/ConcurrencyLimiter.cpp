@@ -0,0 +1,118 @@
+#include <algorithm>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "common/node/Node.h"
+#include "ConcurrencyLimiter.h"
+
+void ConcurrencyLimiter::configure(Option option)
+{
+    if (option.minLimit == 0 || option.minLimit > option.maxLimit)
+        throw std::runtime_error("concurrency limits should satisfy 0 < minLimit <= maxLimit");
+    if (option.tolerance <= 1.0)
+        throw std::runtime_error("rtt tolerance should be greater than 1");
+
+    auto limiter = instance();
+    std::lock_guard<std::mutex> lock(limiter->m_mutex);
+    limiter->m_option = option;
+    limiter->m_limit = std::clamp<double>(option.initialLimit, option.minLimit, option.maxLimit);
+}
+
+Napi::Value ConcurrencyLimiter::status()
+{
+    Napi::Env env = Node::getEnv();
+    auto limiter = instance();
+    std::lock_guard<std::mutex> lock(limiter->m_mutex);
+
+    auto result = Napi::Object::New(env);
+    result.Set("limit", static_cast<double>(static_cast<uint32_t>(limiter->m_limit)));
+    result.Set("inflight", static_cast<double>(limiter->m_inflight));
+    result.Set("queued", static_cast<double>(limiter->m_queue.size()));
+    result.Set("started", static_cast<double>(limiter->m_started));
+    result.Set("rejected", static_cast<double>(limiter->m_rejected));
+    result.Set("minRttMs", limiter->m_minRtt);
+    result.Set("lastRttMs", limiter->m_lastRtt);
+    return result;
+}
+
+void ConcurrencyLimiter::submit(Call call, Reject reject)
+{
+    Pending pending{ std::move(call), std::move(reject) };
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_inflight >= static_cast<uint32_t>(m_limit))
+        {
+            if (m_queue.size() >= m_option.maxQueue)
+            {
+                ++m_rejected;
+                throw CodedError(kOverloadedCode, fmt::format(
+                    "rpc rejected : {} calls in flight and {} queued", m_inflight, m_queue.size()));
+            }
+            m_queue.push_back(std::move(pending));
+            return;
+        }
+        ++m_inflight;
+        ++m_started;
+    }
+    start(std::move(pending));
+}
+
+void ConcurrencyLimiter::start(Pending pending)
+{
+    auto begin = Clock::now();
+    try
+    {
+        pending.call([this, begin](bool succeeded) { complete(begin, succeeded); });
+    }
+    catch (const std::exception& e)
+    {
+        // the call never went out, free its slot without an rtt sample
+        complete(begin, false);
+        pending.reject(e.what());
+    }
+}
+
+void ConcurrencyLimiter::complete(Clock::time_point begin, bool sampled)
+{
+    auto now = Clock::now();
+    std::deque<Pending> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_inflight;
+        if (sampled)
+            sample(std::chrono::duration<double, std::milli>(now - begin).count(), now);
+
+        while (!m_queue.empty() && m_inflight < static_cast<uint32_t>(m_limit))
+        {
+            ready.push_back(std::move(m_queue.front()));
+            m_queue.pop_front();
+            ++m_inflight;
+            ++m_started;
+        }
+    }
+
+    for (auto& pending : ready)
+        start(std::move(pending));
+}
+
+void ConcurrencyLimiter::sample(double rtt, Clock::time_point now)
+{
+    m_lastRtt = rtt;
+    ++m_samples;
+    if (m_minRtt == 0 || rtt < m_minRtt || m_samples % kRttProbeInterval == 0)
+        m_minRtt = rtt;
+
+    if (rtt > m_minRtt * m_option.tolerance)
+    {
+        if (now - m_lastDecrease > std::chrono::duration<double, std::milli>(rtt))
+        {
+            m_limit = std::max<double>(m_option.minLimit, m_limit * kBackoff);
+            m_lastDecrease = now;
+        }
+    }
+    else if (m_inflight + 1 >= m_limit / 2)
+    {
+        // only grow a limit that is actually used
+        m_limit = std::min<double>(m_option.maxLimit, m_limit + 1.0 / m_limit);
+    }
+}
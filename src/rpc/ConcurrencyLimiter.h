@@ -0,0 +1,75 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <functional>
+
+#include <napi.h>
+
+#include "common/binding/CodedError.h"
+#include "common/utils/Singleton.h"
+
+//
+// adaptive limit on in flight rpc calls (AIMD on the observed round trip time) : while calls come back within
+// `tolerance` times the best rtt seen the limit grows by one per window, beyond that it is cut by kBackoff,
+// at most once per rtt. calls over the limit wait in a bounded queue, a full queue rejects right away
+//
+class ConcurrencyLimiter : public Singleton<ConcurrencyLimiter>
+{
+public:
+    struct Option
+    {
+        uint32_t initialLimit = 16;
+        uint32_t minLimit = 1;
+        uint32_t maxLimit = 512;
+        uint32_t maxQueue = 1024;
+        double tolerance = 2.0;
+    };
+
+    static constexpr const char* kOverloadedCode = "ERR_RPC_OVERLOADED";
+    static constexpr double kBackoff = 0.9;
+    // the rtt baseline is re-probed regularly, so a permanently slower server does not pin the limit at its minimum
+    static constexpr uint64_t kRttProbeInterval = 1000;
+
+    // reports the response (true, its rtt is sampled) or the failure of a started call, exactly once
+    using Done = std::function<void(bool succeeded)>;
+    using Call = std::function<void(Done)>;
+    using Reject = std::function<void(const std::string& error)>;
+
+    static void configure(Option option);
+    static Napi::Value status();
+
+    // starts `call` now or once a slot frees up, throws a CodedError (kOverloadedCode) when the queue is full.
+    // `reject` receives the error of a queued call that fails to start
+    void submit(Call call, Reject reject);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending
+    {
+        Call call;
+        Reject reject;
+    };
+
+    void start(Pending pending);
+    void complete(Clock::time_point begin, bool sampled);
+    void sample(double rtt, Clock::time_point now);
+
+    std::mutex m_mutex;
+    Option m_option;
+    double m_limit = 16;
+    uint32_t m_inflight = 0;
+    std::deque<Pending> m_queue;
+
+    double m_minRtt = 0;
+    double m_lastRtt = 0;
+    uint64_t m_samples = 0;
+    Clock::time_point m_lastDecrease;
+
+    uint64_t m_started = 0;
+    uint64_t m_rejected = 0;
+};
@@ -0,0 +1,472 @@
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "common/node/Node.h"
+#include "ConnectionManager.h"
+
+namespace
+{
+    std::string identity(const fbrpc::sTCPOption& endpoint)
+    {
+        return fmt::format("{}:{}", endpoint.address, endpoint.port);
+    }
+}
+
+ConnectionManager::ConnectionManager(Option option)
+    : m_option(std::move(option))
+{
+    m_idempotent = std::unordered_set<std::string>(m_option.idempotent.begin(), m_option.idempotent.end());
+}
+
+ConnectionManager::~ConnectionManager()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_worker.joinable())
+        m_worker.join();
+
+    // no response can come anymore once the clients are gone
+    m_client.reset();
+    m_retired.clear();
+
+    std::vector<Failed> failed;
+    auto metrics = TransportMetrics::instance();
+    for (auto& [id, pending] : m_pending)
+    {
+        (pending.generation ? metrics->inflight : metrics->queued).fetch_sub(1, std::memory_order_relaxed);
+        failed.push_back({ std::move(pending.onFailure), fmt::format("{} : the connection was closed", pending.method->name) });
+    }
+    m_pending.clear();
+    fail(failed);
+}
+
+void ConnectionManager::configure(Option option)
+{
+    if (option.initialDelayMs == 0 || option.initialDelayMs > option.maxDelayMs)
+        throw std::runtime_error("reconnect delays should satisfy 0 < initialDelayMs <= maxDelayMs");
+    if (option.jitter < 0 || option.jitter >= 1)
+        throw std::runtime_error("reconnect jitter should be in [0, 1)");
+
+    auto manager = instance();
+    std::lock_guard<std::mutex> lock(manager->m_mutex);
+    manager->m_idempotent = std::unordered_set<std::string>(option.idempotent.begin(), option.idempotent.end());
+    manager->m_option = std::move(option);
+    if (!manager->m_endpoints.empty())
+    {
+        auto primary = manager->m_endpoints.front();
+        manager->m_endpoints = { primary };
+        manager->m_endpoints.insert(manager->m_endpoints.end(), manager->m_option.fallbacks.begin(), manager->m_option.fallbacks.end());
+        manager->m_current %= manager->m_endpoints.size();
+    }
+}
+
+ConnectionManager::Option ConnectionManager::option() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_option;
+}
+
+Napi::Value ConnectionManager::status()
+{
+    Napi::Env env = Node::getEnv();
+    auto manager = instance();
+    std::lock_guard<std::mutex> lock(manager->m_mutex);
+
+    size_t inflight = 0;
+    for (auto& [id, pending] : manager->m_pending)
+        inflight += pending.generation != 0;
+
+    auto result = Napi::Object::New(env);
+    static const char* kStates[] = { "idle", "connecting", "connected" };
+    result.Set("state", kStates[static_cast<int>(manager->m_state)]);
+    result.Set("endpoint", manager->m_endpoints.empty() ? std::string() : identity(manager->m_endpoints[manager->m_current]));
+    result.Set("attempt", static_cast<double>(manager->m_attempt));
+    result.Set("reconnects", static_cast<double>(manager->m_reconnects));
+    result.Set("replayed", static_cast<double>(manager->m_replayed));
+    result.Set("failed", static_cast<double>(manager->m_failed));
+    result.Set("inflight", static_cast<double>(inflight));
+    result.Set("queued", static_cast<double>(manager->m_pending.size() - inflight));
+    return result;
+}
+
+void ConnectionManager::connect(fbrpc::sTCPOption endpoint, Connected connected)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    bool moved = m_endpoints.empty() || identity(m_endpoints.front()) != identity(endpoint);
+    m_endpoints = { std::move(endpoint) };
+    m_endpoints.insert(m_endpoints.end(), m_option.fallbacks.begin(), m_option.fallbacks.end());
+
+    if (m_state == State::kConnected && !moved)
+    {
+        lock.unlock();
+        connected(true, {});
+        return;
+    }
+
+    // another server : the calls in flight on the current one are handled as on a drop
+    std::vector<Failed> failed;
+    if (m_state == State::kConnected)
+        failed = requeue("the client moved to another server");
+
+    m_waiters.push_back(std::move(connected));
+    m_state = State::kConnecting;
+    m_attempt = 0;
+    m_current = 0;
+    m_restart = true;
+    if (!m_worker.joinable())
+        m_worker = std::thread(&ConnectionManager::run, this);
+    m_wake.notify_all();
+    lock.unlock();
+    fail(failed);
+}
+
+std::shared_ptr<fbrpc::sFlatBufferRpcClient> ConnectionManager::client() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_state != State::kConnected)
+        throw std::runtime_error("client is not connected");
+    return m_client;
+}
+
+void ConnectionManager::call(const RpcMethod& method, fbrpc::sBuffer request, RpcMethod::ResponseHandler onResponse, Failure onFailure)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_state == State::kIdle)
+        throw CodedError(kDisconnectedCode, "client is not connected");
+
+    auto id = ++m_nextId;
+    auto& pending = m_pending[id];
+    pending.method = &method;
+    pending.request = std::move(request);
+    pending.onResponse = std::move(onResponse);
+    pending.onFailure = std::move(onFailure);
+    pending.idempotent = m_idempotent.count(method.name) != 0;
+    pending.queuedAt = Clock::now();
+
+    auto metrics = TransportMetrics::instance();
+    // sent by flush() once connected
+    if (m_state != State::kConnected)
+    {
+        metrics->queued.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    metrics->inflight.fetch_add(1, std::memory_order_relaxed);
+    pending.generation = m_generation;
+    pending.sentAt = Clock::now();
+    auto generation = m_generation;
+    auto client = m_client;
+    auto copy = *pending.request;
+    lock.unlock();
+    send(id, generation, client, method, std::move(copy));
+}
+
+void ConnectionManager::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping)
+    {
+        std::vector<std::shared_ptr<fbrpc::sFlatBufferRpcClient>> released;
+        if (m_state != State::kConnecting)
+        {
+            // also the period queued calls are expired at
+            m_wake.wait_for(lock, std::chrono::milliseconds(100), [this] { return m_stopping || m_state == State::kConnecting; });
+        }
+        else
+        {
+            m_restart = false;
+            if (!m_wake.wait_for(lock, backoff(), [this] { return m_stopping || m_restart; }))
+                released = attempt(lock);
+        }
+
+        // replaced clients nothing holds anymore
+        for (auto it = m_retired.begin(); it != m_retired.end();)
+        {
+            if (it->use_count() == 1)
+            {
+                released.push_back(std::move(*it));
+                it = m_retired.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        auto failed = expire(m_state == State::kIdle);
+        lock.unlock();
+        released.clear();
+        fail(failed);
+        lock.lock();
+    }
+}
+
+std::vector<std::shared_ptr<fbrpc::sFlatBufferRpcClient>> ConnectionManager::attempt(std::unique_lock<std::mutex>& lock)
+{
+    auto endpoint = m_endpoints[m_current];
+    auto generation = ++m_generation;
+    std::shared_ptr<fbrpc::sFlatBufferRpcClient> client = fbrpc::sFlatBufferRpcClient::create(fbrpc::sTCPOption(endpoint));
+    client->on<fbrpc::sError>([this, generation](const fbrpc::sError& e)
+        {
+            onEvent(generation, false, e.msg);
+        }
+    );
+    client->on<fbrpc::sConnectionEvent>([this, generation](const fbrpc::sConnectionEvent& e)
+        {
+            onEvent(generation, true, {});
+        }
+    );
+
+    m_result.reset();
+    lock.unlock();
+    client->connect();
+    lock.lock();
+    m_wake.wait_for(lock, std::chrono::milliseconds(m_option.connectTimeoutMs),
+        [this] { return m_stopping || m_restart || m_result.has_value(); });
+
+    std::vector<std::shared_ptr<fbrpc::sFlatBufferRpcClient>> released;
+    if (m_stopping || (m_restart && !(m_result && m_result->first)))
+    {
+        // the waiters are for the restarted attempts
+        released.push_back(std::move(client));
+        return released;
+    }
+
+    auto waiters = std::move(m_waiters);
+    m_waiters.clear();
+    if (m_result && m_result->first)
+    {
+        if (m_client)
+            m_retired.push_back(std::move(m_client));
+        m_client = std::move(client);
+        m_state = State::kConnected;
+        m_attempt = 0;
+        if (m_connectedOnce)
+        {
+            ++m_reconnects;
+            TransportMetrics::instance()->reconnects.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_connectedOnce = true;
+
+        flush(lock);
+        lock.unlock();
+        for (auto& waiter : waiters)
+            waiter(true, {});
+        lock.lock();
+        return released;
+    }
+
+    auto message = m_result ? m_result->second : fmt::format("{} : no connection after {} ms", identity(endpoint), m_option.connectTimeoutMs);
+    released.push_back(std::move(client));
+    ++m_attempt;
+    m_current = (m_current + 1) % m_endpoints.size();
+    if (m_option.maxAttempts && m_attempt >= m_option.maxAttempts)
+        m_state = State::kIdle;
+
+    lock.unlock();
+    for (auto& waiter : waiters)
+        waiter(false, message);
+    lock.lock();
+    return released;
+}
+
+void ConnectionManager::onEvent(uint64_t generation, bool connected, const std::string& message)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (generation != m_generation)
+        return;
+
+    if (m_state == State::kConnecting)
+    {
+        if (!m_result)
+            m_result.emplace(connected, message);
+        m_wake.notify_all();
+        return;
+    }
+    if (m_state != State::kConnected || connected)
+        return;
+
+    // dropped : the first attempt goes right away to the next endpoint
+    m_state = State::kConnecting;
+    m_attempt = 0;
+    m_current = (m_current + 1) % m_endpoints.size();
+
+    auto failed = requeue("connection lost with the request in flight");
+    m_wake.notify_all();
+    lock.unlock();
+    fail(failed);
+}
+
+std::vector<ConnectionManager::Failed> ConnectionManager::requeue(const char* reason)
+{
+    std::vector<Failed> failed;
+    for (auto it = m_pending.begin(); it != m_pending.end();)
+    {
+        auto& pending = it->second;
+        if (pending.generation == 0)
+        {
+            ++it;
+        }
+        else if (pending.idempotent)
+        {
+            pending.generation = 0;
+            pending.queuedAt = Clock::now();
+            ++m_replayed;
+            TransportMetrics::instance()->inflight.fetch_sub(1, std::memory_order_relaxed);
+            TransportMetrics::instance()->queued.fetch_add(1, std::memory_order_relaxed);
+            ++it;
+        }
+        else
+        {
+            TransportMetrics::instance()->inflight.fetch_sub(1, std::memory_order_relaxed);
+            failed.push_back({ std::move(pending.onFailure), fmt::format("{} : {}", pending.method->name, reason) });
+            ++m_failed;
+            it = m_pending.erase(it);
+        }
+    }
+    return failed;
+}
+
+void ConnectionManager::onResponse(uint64_t id, uint64_t generation, fbrpc::sBuffer response)
+{
+    auto metrics = TransportMetrics::instance();
+    metrics->received(response.length);
+
+    RpcMethod::ResponseHandler onResponse;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pending.find(id);
+        // already failed, or sent again on a newer connection
+        if (it == m_pending.end() || it->second.generation != generation)
+            return;
+
+        metrics->sampleRtt(it->second.sentAt);
+        metrics->inflight.fetch_sub(1, std::memory_order_relaxed);
+        onResponse = std::move(it->second.onResponse);
+        m_pending.erase(it);
+    }
+    onResponse(std::move(response));
+}
+
+void ConnectionManager::flush(std::unique_lock<std::mutex>& lock)
+{
+    struct Queued
+    {
+        uint64_t id;
+        const RpcMethod* method;
+        fbrpc::sBuffer request;
+    };
+
+    std::vector<Queued> queued;
+    for (auto& [id, pending] : m_pending)
+    {
+        if (pending.generation != 0)
+            continue;
+        pending.generation = m_generation;
+        pending.sentAt = Clock::now();
+        queued.push_back({ id, pending.method, *pending.request });
+    }
+    if (queued.empty())
+        return;
+
+    auto metrics = TransportMetrics::instance();
+    metrics->queued.fetch_sub(queued.size(), std::memory_order_relaxed);
+    metrics->inflight.fetch_add(queued.size(), std::memory_order_relaxed);
+
+    auto generation = m_generation;
+    auto client = m_client;
+    lock.unlock();
+    for (auto& call : queued)
+        send(call.id, generation, client, *call.method, std::move(call.request));
+    lock.lock();
+}
+
+std::vector<ConnectionManager::Failed> ConnectionManager::expire(bool all)
+{
+    auto deadline = Clock::now() - std::chrono::milliseconds(m_option.queueTimeoutMs);
+    std::vector<Failed> failed;
+    for (auto it = m_pending.begin(); it != m_pending.end();)
+    {
+        auto& pending = it->second;
+        if (pending.generation != 0 || (!all && pending.queuedAt > deadline))
+        {
+            ++it;
+            continue;
+        }
+
+        auto error = all
+            ? fmt::format("{} : gave up reconnecting after {} attempts", pending.method->name, m_attempt)
+            : fmt::format("{} : no connection within {} ms", pending.method->name, m_option.queueTimeoutMs);
+        failed.push_back({ std::move(pending.onFailure), std::move(error) });
+        ++m_failed;
+        TransportMetrics::instance()->queued.fetch_sub(1, std::memory_order_relaxed);
+        it = m_pending.erase(it);
+    }
+    return failed;
+}
+
+void ConnectionManager::send(uint64_t id, uint64_t generation, const std::shared_ptr<fbrpc::sFlatBufferRpcClient>& client, const RpcMethod& method, fbrpc::sBuffer request)
+{
+    try
+    {
+        TransportMetrics::instance()->sent(request.length);
+        // the handlers don't hold the client : it stores them, m_client / m_retired keep it alive
+        method.dispatch(client, std::move(request),
+            [this, id, generation](fbrpc::sBuffer response)
+            {
+                onResponse(id, generation, std::move(response));
+            },
+            [this, id, generation](const std::string& error)
+            {
+                onSendFailure(id, generation, error);
+            }
+        );
+    }
+    catch (const std::exception& e)
+    {
+        onSendFailure(id, generation, e.what());
+    }
+}
+
+void ConnectionManager::onSendFailure(uint64_t id, uint64_t generation, const std::string& error)
+{
+    Failure onFailure;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pending.find(id);
+        if (it == m_pending.end() || it->second.generation != generation)
+            return;
+        onFailure = std::move(it->second.onFailure);
+        m_pending.erase(it);
+        ++m_failed;
+        TransportMetrics::instance()->inflight.fetch_sub(1, std::memory_order_relaxed);
+    }
+    onFailure(error, nullptr);
+}
+
+std::chrono::milliseconds ConnectionManager::backoff()
+{
+    if (m_attempt == 0)
+        return std::chrono::milliseconds(0);
+
+    // worker thread only
+    static std::mt19937 random{ std::random_device{}() };
+    auto exponent = std::min<uint32_t>(m_attempt - 1, 30);
+    auto delay = std::min<double>(m_option.maxDelayMs, static_cast<double>(m_option.initialDelayMs) * std::pow(2.0, exponent));
+    std::uniform_real_distribution<double> jitter(1.0 - m_option.jitter, 1.0 + m_option.jitter);
+    return std::chrono::milliseconds(static_cast<int64_t>(delay * jitter(random)));
+}
+
+void ConnectionManager::fail(std::vector<Failed>& failed)
+{
+    for (auto& call : failed)
+        call.onFailure(call.error, kDisconnectedCode);
+    failed.clear();
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <functional>
+#include <unordered_set>
+#include <unordered_map>
+#include <condition_variable>
+
+#include <napi.h>
+
+#include "fbrpc/ssFlatBufferRpc.h"
+#include "common/binding/CodedError.h"
+#include "common/utils/Singleton.h"
+#include "RpcMethod.h"
+#include "TransportMetrics.h"
+
+//
+// the connection behind FlatbufferClient : a dropped connection is re-established by a worker thread, first right
+// away on the next configured endpoint (failover), then with jittered exponential backoff across all of them.
+// calls dispatched through call() (every generated service call, see ServiceCall) are journaled until their
+// response : those sent on the dropped connection are sent again after the reconnect when their method is
+// idempotent (Reconnect.configure) and failed with kDisconnectedCode otherwise, calls made while reconnecting
+// wait (up to queueTimeoutMs) for the new connection. ShardedClient runs one more per shard
+//
+class ConnectionManager : public Singleton<ConnectionManager>
+{
+public:
+    struct Option
+    {
+        // tried in turn after the endpoint given to connect
+        std::vector<fbrpc::sTCPOption> fallbacks;
+        uint32_t initialDelayMs = 50;
+        uint32_t maxDelayMs = 5000;
+        // +- part of each delay picked at random, so clients don't reconnect in lockstep
+        double jitter = 0.2;
+        uint32_t connectTimeoutMs = 3000;
+        uint32_t queueTimeoutMs = 10000;
+        // consecutive failed attempts before giving up, 0 retries forever
+        uint32_t maxAttempts = 0;
+        // Service.method safe to send twice
+        std::vector<std::string> idempotent;
+    };
+
+    static constexpr const char* kDisconnectedCode = "ERR_RPC_DISCONNECTED";
+
+    using Connected = std::function<void(bool connected, const std::string& message)>;
+    using Failure = std::function<void(const std::string& error, const char* code)>;
+
+    ConnectionManager() = default;
+    // a shard connection, see ShardedClient
+    explicit ConnectionManager(Option option);
+    // fails the calls it still holds
+    ~ConnectionManager();
+
+    static void configure(Option option);
+    static Napi::Value status();
+
+    Option option() const;
+
+    // (re)starts connecting with `endpoint` first, `connected` gets the result of the first attempt.
+    // already connected to `endpoint`, `connected` is called right away
+    void connect(fbrpc::sTCPOption endpoint, Connected connected);
+
+    // the connected client, throws when there is none. a client replaced by a reconnect is released by the
+    // worker thread once nothing else holds it, never from one of its own callbacks
+    std::shared_ptr<fbrpc::sFlatBufferRpcClient> client() const;
+
+    // journaled dispatch, exactly one of onResponse / onFailure is called
+    void call(const RpcMethod& method, fbrpc::sBuffer request, RpcMethod::ResponseHandler onResponse, Failure onFailure);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class State
+    {
+        kIdle,
+        kConnecting,
+        kConnected
+    };
+
+    struct Pending
+    {
+        const RpcMethod* method = nullptr;
+        std::optional<fbrpc::sBuffer> request;
+        RpcMethod::ResponseHandler onResponse;
+        Failure onFailure;
+        bool idempotent = false;
+        // connection it was sent on, 0 while queued
+        uint64_t generation = 0;
+        Clock::time_point queuedAt;
+        Clock::time_point sentAt;
+    };
+
+    struct Failed
+    {
+        Failure onFailure;
+        std::string error;
+    };
+
+    void run();
+    // returns the clients to release once the lock is gone, their destruction may call back into onEvent
+    std::vector<std::shared_ptr<fbrpc::sFlatBufferRpcClient>> attempt(std::unique_lock<std::mutex>& lock);
+    void onEvent(uint64_t generation, bool connected, const std::string& message);
+    // queues the calls in flight again (idempotent ones) or removes them to be failed with `reason`
+    std::vector<Failed> requeue(const char* reason);
+    void onResponse(uint64_t id, uint64_t generation, fbrpc::sBuffer response);
+    void onSendFailure(uint64_t id, uint64_t generation, const std::string& error);
+    // sends the queued calls, the lock is released meanwhile
+    void flush(std::unique_lock<std::mutex>& lock);
+    // removes and returns the queued calls older than queueTimeoutMs (all of them with `all`)
+    std::vector<Failed> expire(bool all);
+    void send(uint64_t id, uint64_t generation, const std::shared_ptr<fbrpc::sFlatBufferRpcClient>& client, const RpcMethod& method, fbrpc::sBuffer request);
+    std::chrono::milliseconds backoff();
+
+    static void fail(std::vector<Failed>& failed);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_worker;
+    bool m_stopping = false;
+    bool m_restart = false;
+
+    Option m_option;
+    std::unordered_set<std::string> m_idempotent;
+    std::vector<fbrpc::sTCPOption> m_endpoints;
+    size_t m_current = 0;
+
+    State m_state = State::kIdle;
+    uint64_t m_generation = 0;
+    uint32_t m_attempt = 0;
+    std::optional<std::pair<bool, std::string>> m_result; // of the attempt in progress
+    std::shared_ptr<fbrpc::sFlatBufferRpcClient> m_client;
+    std::vector<std::shared_ptr<fbrpc::sFlatBufferRpcClient>> m_retired;
+    std::vector<Connected> m_waiters;
+    bool m_connectedOnce = false;
+
+    uint64_t m_nextId = 0;
+    std::unordered_map<uint64_t, Pending> m_pending;
+
+    uint64_t m_reconnects = 0;
+    uint64_t m_replayed = 0;
+    uint64_t m_failed = 0;
+};
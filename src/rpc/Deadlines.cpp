@@ -0,0 +1,73 @@
+#include "Deadlines.h"
+
+Deadlines::~Deadlines()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_worker.joinable())
+        m_worker.join();
+}
+
+uint64_t Deadlines::schedule(std::chrono::milliseconds delay, Callback callback)
+{
+    auto due = Clock::now() + delay;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto id = ++m_nextId;
+    bool earliest = m_timers.empty() || due < m_timers.begin()->first.first;
+    m_timers.emplace(std::make_pair(due, id), std::move(callback));
+    m_due.emplace(id, due);
+
+    if (!m_worker.joinable())
+        m_worker = std::thread(&Deadlines::run, this);
+    else if (earliest)
+        m_wake.notify_one();
+    return id;
+}
+
+void Deadlines::cancel(uint64_t id)
+{
+    Callback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_due.find(id);
+        if (it == m_due.end())
+            return;
+
+        auto timer = m_timers.find(std::make_pair(it->second, id));
+        callback = std::move(timer->second);
+        m_timers.erase(timer);
+        m_due.erase(it);
+    }
+    // what it captures is released without the lock
+}
+
+void Deadlines::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping)
+    {
+        if (m_timers.empty())
+        {
+            m_wake.wait(lock);
+            continue;
+        }
+
+        auto first = m_timers.begin();
+        if (Clock::now() < first->first.first)
+        {
+            m_wake.wait_until(lock, first->first.first);
+            continue;
+        }
+
+        auto callback = std::move(first->second);
+        m_due.erase(first->first.second);
+        m_timers.erase(first);
+        lock.unlock();
+        callback();
+        callback = nullptr;
+        lock.lock();
+    }
+}
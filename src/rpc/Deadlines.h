@@ -0,0 +1,43 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <utility>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "common/utils/Singleton.h"
+
+//
+// one shot timers of the rpc layer, fired in order by a single worker thread started on first use. a callback
+// runs at most once, possibly racing a late cancel(), keep it short : the next deadlines wait for it
+//
+class Deadlines : public Singleton<Deadlines>
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+
+    ~Deadlines();
+
+    // returns the id to cancel it with, never 0
+    uint64_t schedule(std::chrono::milliseconds delay, Callback callback);
+    // a no-op for a fired (or 0) id
+    void cancel(uint64_t id);
+
+private:
+    void run();
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_worker;
+    bool m_stopping = false;
+
+    uint64_t m_nextId = 0;
+    std::map<std::pair<Clock::time_point, uint64_t>, Callback> m_timers;
+    std::unordered_map<uint64_t, Clock::time_point> m_due;
+};
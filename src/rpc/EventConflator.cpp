@@ -0,0 +1,144 @@
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "common/node/Node.h"
+#include "common/binding/BufferPool.h"
+#include "EventConflator.h"
+
+namespace
+{
+    std::string toKey(const DynamicValue& value)
+    {
+        switch (value.kind)
+        {
+        case DynamicValue::Kind::kString:
+            return value.string;
+        case DynamicValue::Kind::kReal:
+            return fmt::format("{}", value.real);
+        case DynamicValue::Kind::kNull:
+            // an absent string key, conflating those together would lose events
+            throw std::runtime_error("the event has no key");
+        default:
+            return std::to_string(value.integer);
+        }
+    }
+}
+
+EventConflator::EventConflator(const Napi::Function& callback, const std::string& rootType, const std::string& keyField)
+    : m_key(ObjectEncoder::resolvePath(SchemaRegistry::instance()->find(rootType), SchemaRegistry::splitPath(keyField)))
+{
+    // the path is resolved once, events then only read it
+    m_function = Napi::ThreadSafeFunction::New(callback.Env(), callback, "EventConflator", 0, 1);
+}
+
+EventConflator::~EventConflator()
+{
+    close();
+}
+
+void EventConflator::push(const fbrpc::sBuffer& event)
+{
+    auto& s = stats();
+    s.events.fetch_add(1, std::memory_order_relaxed);
+
+    std::string key;
+    try
+    {
+        key = toKey(ObjectEncoder::readField(m_key, reinterpret_cast<const uint8_t*>(event.data.get()), event.length));
+    }
+    catch (const std::exception&)
+    {
+        s.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (!m_guard.enter())
+        return;
+
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto [it, inserted] = m_index.try_emplace(std::move(key), m_pending.size());
+        if (inserted)
+            m_pending.push_back(event);
+        else
+        {
+            m_pending[it->second] = event;
+            s.conflated.fetch_add(1, std::memory_order_relaxed);
+        }
+        schedule = !m_scheduled;
+        m_scheduled = true;
+    }
+
+    if (schedule)
+    {
+        auto self = shared_from_this();
+        auto status = m_function.NonBlockingCall([self](Napi::Env env, Napi::Function callback)
+            {
+                self->drain(env, callback);
+            }
+        );
+        if (status != napi_ok)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_scheduled = false;
+        }
+    }
+    m_guard.leave();
+}
+
+void EventConflator::close()
+{
+    if (!m_guard.close())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_index.clear();
+        m_pending.clear();
+    }
+    m_function.Release();
+}
+
+void EventConflator::drain(Napi::Env env, Napi::Function callback)
+{
+    std::vector<fbrpc::sBuffer> events;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        events.swap(m_pending);
+        m_index.clear();
+        m_scheduled = false;
+    }
+    if (env == nullptr || events.empty() || m_guard.closed())
+        return;
+
+    auto array = Napi::Array::New(env, events.size());
+    for (uint32_t i = 0; i < events.size(); ++i)
+        array[i] = BufferPool::instance()->toJs(env, events[i].data.get(), events[i].length);
+
+    auto& s = stats();
+    s.drains.fetch_add(1, std::memory_order_relaxed);
+    s.delivered.fetch_add(events.size(), std::memory_order_relaxed);
+    callback.Call({ array });
+}
+
+EventConflator::Stats& EventConflator::stats()
+{
+    static Stats stats;
+    return stats;
+}
+
+Napi::Value EventConflator::statistics()
+{
+    Napi::Env env = Node::getEnv();
+    auto& s = stats();
+
+    auto result = Napi::Object::New(env);
+    result.Set("events", static_cast<double>(s.events.load()));
+    result.Set("conflated", static_cast<double>(s.conflated.load()));
+    result.Set("delivered", static_cast<double>(s.delivered.load()));
+    result.Set("drains", static_cast<double>(s.drains.load()));
+    result.Set("dropped", static_cast<double>(s.dropped.load()));
+    return result;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include <napi.h>
+
+#include "fbrpc/ssFlatBufferRpc.h"
+#include "common/reflection/ObjectEncoder.h"
+#include "common/utils/UseGuard.h"
+
+//
+// latest value per key delivery for state streams (see Subscriptions.conflate) : the network thread only keeps the
+// newest event of each key, read from `keyField` of the `rootType` table, and js is called once per drain with
+// the events of the keys that changed since the previous one. a drain is only queued when none is pending,
+// so the js cost follows the number of distinct keys instead of the event rate
+//
+class EventConflator : public std::enable_shared_from_this<EventConflator>
+{
+public:
+    struct Stats
+    {
+        std::atomic<uint64_t> events{ 0 };
+        std::atomic<uint64_t> conflated{ 0 }; // replaced before js saw them
+        std::atomic<uint64_t> delivered{ 0 };
+        std::atomic<uint64_t> drains{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };   // invalid, or without a key
+    };
+
+    // js thread, throws when the type or the key field can't be found
+    EventConflator(const Napi::Function& callback, const std::string& rootType, const std::string& keyField);
+    ~EventConflator();
+
+    // network thread
+    void push(const fbrpc::sBuffer& event);
+
+    // drops the pending events and releases the callback
+    void close();
+
+    static Napi::Value statistics();
+
+private:
+    static Stats& stats();
+
+    void drain(Napi::Env env, Napi::Function callback);
+
+    ObjectEncoder::FieldPath m_key;
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, size_t> m_index; // key => slot in m_pending
+    std::vector<fbrpc::sBuffer> m_pending;
+    bool m_scheduled = false;
+
+    Napi::ThreadSafeFunction m_function;
+    UseGuard m_guard;
+};
@@ -0,0 +1,232 @@
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+#ifdef FBRPC_HAS_LZ4
+#include <lz4.h>
+#endif
+#ifdef FBRPC_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#include "common/node/Node.h"
+#include "PayloadCodec.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    PayloadCodec::Algorithm parseAlgorithm(const std::string& name)
+    {
+        if (name == "none")
+            return PayloadCodec::Algorithm::kNone;
+#ifdef FBRPC_HAS_LZ4
+        if (name == "lz4")
+            return PayloadCodec::Algorithm::kLz4;
+#endif
+#ifdef FBRPC_HAS_ZSTD
+        if (name == "zstd")
+            return PayloadCodec::Algorithm::kZstd;
+#endif
+        throw std::runtime_error(fmt::format("unsupported compression : {}", name));
+    }
+
+    uint64_t elapsed(Clock::time_point start)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    }
+
+    // reused per network thread, only grows up to the largest message
+    std::vector<char>& scratch(size_t size)
+    {
+        thread_local std::vector<char> buffer;
+        if (buffer.size() < size)
+            buffer.resize(size);
+        return buffer;
+    }
+
+    Napi::Object toJs(const Napi::Env& env, uint64_t messages, uint64_t rawBytes, uint64_t compressedBytes, uint64_t microseconds)
+    {
+        auto result = Napi::Object::New(env);
+        result.Set("messages", static_cast<double>(messages));
+        result.Set("rawBytes", static_cast<double>(rawBytes));
+        result.Set("compressedBytes", static_cast<double>(compressedBytes));
+        result.Set("ratio", compressedBytes ? static_cast<double>(rawBytes) / compressedBytes : 0.0);
+        result.Set("cpuMs", microseconds / 1000.0);
+        return result;
+    }
+}
+
+void PayloadCodec::configure(Option option)
+{
+    auto codec = instance();
+    codec->m_algorithm = parseAlgorithm(option.algorithm);
+    codec->m_threshold = option.threshold;
+    codec->m_level = option.level;
+    codec->m_maxSize = option.maxSize;
+}
+
+Napi::Value PayloadCodec::metrics()
+{
+    Napi::Env env = Node::getEnv();
+    auto codec = instance();
+    auto& out = codec->m_compressed;
+    auto& in = codec->m_decompressed;
+
+    auto result = Napi::Object::New(env);
+    result.Set("compressed", toJs(env, out.messages, out.rawBytes, out.compressedBytes, out.microseconds));
+    result.Set("decompressed", toJs(env, in.messages, in.rawBytes, in.compressedBytes, in.microseconds));
+    result.Set("skipped", static_cast<double>(codec->m_skipped.load()));
+    result.Set("failed", static_cast<double>(codec->m_failed.load()));
+    return result;
+}
+
+fbrpc::sBuffer PayloadCodec::compress(fbrpc::sBuffer buffer)
+{
+    auto codec = instance();
+    auto algorithm = codec->m_algorithm.load();
+    if (algorithm == Algorithm::kNone)
+        throw std::runtime_error("compression is not configured");
+    return codec->pack(buffer, algorithm, codec->m_level);
+}
+
+fbrpc::sBuffer PayloadCodec::decompress(fbrpc::sBuffer buffer)
+{
+    return instance()->inbound(std::move(buffer));
+}
+
+fbrpc::sBuffer PayloadCodec::outbound(fbrpc::sBuffer buffer)
+{
+    auto frame = encode(buffer);
+    return frame ? std::move(*frame) : std::move(buffer);
+}
+
+fbrpc::sBuffer PayloadCodec::inbound(fbrpc::sBuffer buffer)
+{
+    auto payload = decode(buffer);
+    return payload ? std::move(*payload) : std::move(buffer);
+}
+
+std::optional<fbrpc::sBuffer> PayloadCodec::encode(const fbrpc::sBuffer& buffer)
+{
+    auto algorithm = m_algorithm.load(std::memory_order_relaxed);
+    if (algorithm == Algorithm::kNone || buffer.length < m_threshold.load(std::memory_order_relaxed))
+        return std::nullopt;
+
+    auto packed = pack(buffer, algorithm, m_level.load(std::memory_order_relaxed));
+    if (packed.length >= buffer.length)
+    {
+        m_skipped.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    return packed;
+}
+
+fbrpc::sBuffer PayloadCodec::pack(const fbrpc::sBuffer& buffer, Algorithm algorithm, int level)
+{
+    auto start = Clock::now();
+    auto source = reinterpret_cast<const char*>(buffer.data.get());
+    auto sourceSize = static_cast<size_t>(buffer.length);
+
+    size_t bound = 0;
+#ifdef FBRPC_HAS_LZ4
+    if (algorithm == Algorithm::kLz4)
+        bound = LZ4_compressBound(static_cast<int>(sourceSize));
+#endif
+#ifdef FBRPC_HAS_ZSTD
+    if (algorithm == Algorithm::kZstd)
+        bound = ZSTD_compressBound(sourceSize);
+#endif
+
+    auto& output = scratch(kHeaderSize + bound);
+    auto target = output.data() + kHeaderSize;
+    size_t size = 0;
+#ifdef FBRPC_HAS_LZ4
+    if (algorithm == Algorithm::kLz4)
+        size = LZ4_compress_fast(source, target, static_cast<int>(sourceSize), static_cast<int>(bound), level > 0 ? level : 1);
+#endif
+#ifdef FBRPC_HAS_ZSTD
+    if (algorithm == Algorithm::kZstd)
+    {
+        size = ZSTD_compress(target, bound, source, sourceSize, level);
+        if (ZSTD_isError(size))
+            throw std::runtime_error(fmt::format("zstd compression failed : {}", ZSTD_getErrorName(size)));
+    }
+#endif
+    if (size == 0)
+        throw std::runtime_error("payload compression failed");
+
+    auto magic = kMagic;
+    auto originalSize = static_cast<uint32_t>(sourceSize);
+    std::memset(output.data(), 0, kHeaderSize);
+    std::memcpy(output.data(), &magic, sizeof(magic));
+    output[4] = static_cast<char>(algorithm);
+    std::memcpy(output.data() + 8, &originalSize, sizeof(originalSize));
+
+    m_compressed.messages.fetch_add(1, std::memory_order_relaxed);
+    m_compressed.rawBytes.fetch_add(sourceSize, std::memory_order_relaxed);
+    m_compressed.compressedBytes.fetch_add(size, std::memory_order_relaxed);
+    m_compressed.microseconds.fetch_add(elapsed(start), std::memory_order_relaxed);
+    return fbrpc::sBuffer::clone(output.data(), kHeaderSize + size);
+}
+
+std::optional<fbrpc::sBuffer> PayloadCodec::decode(const fbrpc::sBuffer& buffer)
+{
+    if (buffer.length < kHeaderSize)
+        return std::nullopt;
+
+    auto source = reinterpret_cast<const char*>(buffer.data.get());
+    uint32_t magic = 0;
+    std::memcpy(&magic, source, sizeof(magic));
+    if (magic != kMagic)
+        return std::nullopt;
+
+    auto start = Clock::now();
+    auto algorithm = static_cast<Algorithm>(source[4]);
+    uint32_t originalSize = 0;
+    std::memcpy(&originalSize, source + 8, sizeof(originalSize));
+
+    auto compressed = source + kHeaderSize;
+    auto compressedSize = static_cast<size_t>(buffer.length) - kHeaderSize;
+    if (originalSize > m_maxSize.load(std::memory_order_relaxed) || originalSize > compressedSize * kMaxRatio)
+    {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        throw std::runtime_error(fmt::format("compressed payload of {} bytes claims {} bytes", compressedSize, originalSize));
+    }
+    auto& output = scratch(originalSize);
+    size_t size = 0;
+    bool supported = false;
+#ifdef FBRPC_HAS_LZ4
+    if (algorithm == Algorithm::kLz4)
+    {
+        supported = true;
+        auto result = LZ4_decompress_safe(compressed, output.data(), static_cast<int>(compressedSize), static_cast<int>(originalSize));
+        size = result < 0 ? 0 : static_cast<size_t>(result);
+    }
+#endif
+#ifdef FBRPC_HAS_ZSTD
+    if (algorithm == Algorithm::kZstd)
+    {
+        supported = true;
+        size = ZSTD_decompress(output.data(), originalSize, compressed, compressedSize);
+        if (ZSTD_isError(size))
+            size = 0;
+    }
+#endif
+    if (!supported || size != originalSize)
+    {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        if (!supported)
+            throw std::runtime_error(fmt::format("unsupported compressed payload (algorithm {})", static_cast<int>(algorithm)));
+        throw std::runtime_error("corrupted compressed payload");
+    }
+
+    m_decompressed.messages.fetch_add(1, std::memory_order_relaxed);
+    m_decompressed.rawBytes.fetch_add(originalSize, std::memory_order_relaxed);
+    m_decompressed.compressedBytes.fetch_add(compressedSize, std::memory_order_relaxed);
+    m_decompressed.microseconds.fetch_add(elapsed(start), std::memory_order_relaxed);
+    return fbrpc::sBuffer::clone(output.data(), originalSize);
+}
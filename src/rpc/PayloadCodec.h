@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <optional>
+#include <cstdint>
+
+#include <napi.h>
+
+#include "fbrpc/ssFlatBufferRpc.h"
+#include "common/utils/Singleton.h"
+
+//
+// optional lz4 / zstd compression of rpc payloads above a size threshold. a compressed payload is framed as
+//
+//   [uint32 kMagic][uint8 algorithm][3 reserved][uint32 original size][compressed bytes]
+//
+// kMagic read as a flatbuffer root offset points past 1.5GB, so plain flatbuffers are never mistaken for a frame
+// and decode() passes them through : inbound frames are always understood, outbound compression is only turned on
+// (Compression.configure) for peers known to accept it. decoding runs on the network thread, before js sees the buffer
+//
+class PayloadCodec : public Singleton<PayloadCodec>
+{
+public:
+    enum class Algorithm : uint8_t
+    {
+        kNone,
+        kLz4,
+        kZstd
+    };
+
+    struct Option
+    {
+        std::string algorithm; // 'none', 'lz4' or 'zstd'
+        uint32_t threshold = 64 * 1024;
+        int level = 0;         // zstd level, lz4 acceleration, 0 for the library default
+        uint32_t maxSize = 64 * 1024 * 1024; // largest payload an inbound frame may expand to
+    };
+
+    static constexpr uint32_t kMagic = 0x5A4246FF; // ff 'F' 'B' 'Z'
+    static constexpr size_t kHeaderSize = 12;
+    // an inbound frame claiming more is corrupted (or hostile) : its original size is never allocated
+    static constexpr size_t kMaxRatio = 1024;
+
+    static void configure(Option option);
+    static Napi::Value metrics();
+
+    // same transforms as the transport, for tools and stand-in servers
+    static fbrpc::sBuffer compress(fbrpc::sBuffer buffer);
+    static fbrpc::sBuffer decompress(fbrpc::sBuffer buffer);
+
+    // outbound : the compressed frame when enabled, above the threshold and actually smaller
+    std::optional<fbrpc::sBuffer> encode(const fbrpc::sBuffer& buffer);
+    // inbound : the payload of a compressed frame, nothing for a plain one. throws on a corrupted frame
+    std::optional<fbrpc::sBuffer> decode(const fbrpc::sBuffer& buffer);
+
+    // encode() / decode() falling back to the buffer itself
+    fbrpc::sBuffer outbound(fbrpc::sBuffer buffer);
+    fbrpc::sBuffer inbound(fbrpc::sBuffer buffer);
+
+private:
+    fbrpc::sBuffer pack(const fbrpc::sBuffer& buffer, Algorithm algorithm, int level);
+
+    struct Counters
+    {
+        std::atomic<uint64_t> messages{ 0 };
+        std::atomic<uint64_t> rawBytes{ 0 };
+        std::atomic<uint64_t> compressedBytes{ 0 };
+        std::atomic<uint64_t> microseconds{ 0 };
+    };
+
+    std::atomic<Algorithm> m_algorithm{ Algorithm::kNone };
+    std::atomic<uint32_t> m_threshold{ 64 * 1024 };
+    std::atomic<int> m_level{ 0 };
+    std::atomic<uint32_t> m_maxSize{ 64 * 1024 * 1024 };
+
+    Counters m_compressed;
+    Counters m_decompressed;
+    std::atomic<uint64_t> m_skipped{ 0 }; // above the threshold but not smaller once compressed
+    std::atomic<uint64_t> m_failed{ 0 };  // inbound frames dropped
+};
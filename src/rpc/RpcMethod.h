@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <functional>
+#include <unordered_map>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "fbrpc/ssFlatBufferRpc.h"
+#include "common/utils/Singleton.h"
+#include "common/reflection/SchemaRegistry.h"
+
+//
+// raw (buffer in, buffer out) entry points of the generated services, one per function FlatBufferBinding::bind
+// binds (see ServiceCall), so native code can dispatch calls by name without js
+//
+struct RpcMethod
+{
+    using ResponseHandler = std::function<void(fbrpc::sBuffer)>;
+    using FailureHandler = std::function<void(const std::string& error)>;
+    // any thread, exactly one of the handlers is called. the client is kept alive until the request is sent
+    using Dispatch = std::function<void(std::shared_ptr<fbrpc::sFlatBufferRpcClient>, fbrpc::sBuffer, ResponseHandler, FailureHandler)>;
+
+    // Service.method, eg : ExampleAPI.helloWorld
+    std::string name;
+
+    // request / response table names, resolved through SchemaRegistry when a schema driven feature needs them.
+    // empty for the generated methods, their types then come from the rpc_service of the loaded schemas
+    std::string requestType;
+    std::string responseType;
+
+    Dispatch dispatch;
+
+    // the raw call of the fbrpc client : `request` goes out as is under the method id ("Service.method"), the
+    // response comes back undecoded on a network thread. a broken connection is reported by the client's sError
+    // event (see ConnectionManager), not per call
+    static void send(fbrpc::sFlatBufferRpcClient& client, const std::string& id, fbrpc::sBuffer request, ResponseHandler onResponse)
+    {
+        client.call(id, std::move(request), std::move(onResponse));
+    }
+
+    SchemaRegistry::Type requestSchema() const
+    {
+        auto registry = SchemaRegistry::instance();
+        return requestType.empty() ? registry->findCall(name).request : registry->find(requestType);
+    }
+
+    SchemaRegistry::Type responseSchema() const
+    {
+        auto registry = SchemaRegistry::instance();
+        return responseType.empty() ? registry->findCall(name).response : registry->find(responseType);
+    }
+};
+
+class RpcMethodRegistry : public Singleton<RpcMethodRegistry>
+{
+public:
+    void add(RpcMethod method)
+    {
+        auto name = method.name;
+        m_methods[name] = std::move(method);
+    }
+
+    const RpcMethod& find(const std::string& name) const
+    {
+        auto it = m_methods.find(name);
+        if (it == m_methods.end())
+            throw std::runtime_error(fmt::format("unknown rpc method : {}", name));
+        return it->second;
+    }
+
+private:
+    std::unordered_map<std::string, RpcMethod> m_methods;
+};
@@ -0,0 +1,235 @@
+#include <chrono>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "common/reflection/ObjectEncoder.h"
+#include "PayloadCodec.h"
+#include "ConcurrencyLimiter.h"
+#include "ConnectionManager.h"
+#include "ShardedClient.h"
+#include "TrafficCapture.h"
+#include "Deadlines.h"
+#include "RpcPipeline.h"
+
+Napi::Value RpcPipeline::run(Napi::Value steps)
+{
+    Napi::Env env = steps.Env();
+    if (!steps.IsArray() || steps.As<Napi::Array>().Length() == 0)
+        throw std::runtime_error("pipeline expects a non empty array of steps");
+
+    auto pipeline = std::make_shared<RpcPipeline>();
+    auto array = steps.As<Napi::Array>();
+    for (uint32_t i = 0; i < array.Length(); ++i)
+    {
+        try
+        {
+            auto step = parseStep(array.Get(i), pipeline->m_steps.empty() ? nullptr : &pipeline->m_steps.back());
+            pipeline->m_steps.push_back(std::move(step));
+        }
+        catch (const std::runtime_error& e)
+        {
+            throw std::runtime_error(fmt::format("pipeline step {} : {}", i, e.what()));
+        }
+    }
+
+    auto promise = Napi::Promise::Deferred::New(env);
+    pipeline->m_resolver = std::make_shared<Resolver<fbrpc::sBuffer>>(promise);
+    pipeline->next(0, nullptr);
+    return promise.Promise();
+}
+
+RpcPipeline::Step RpcPipeline::parseStep(const Napi::Value& value, Step* previous)
+{
+    if (!value.IsObject())
+        throw std::runtime_error("a step should be an object");
+
+    auto obj = value.As<Napi::Object>();
+    Napi::Value method = obj.Get("method");
+    Napi::Value request = obj.Get("request");
+    Napi::Value map = obj.Get("map");
+    Napi::Value timeout = obj.Get("timeoutMs");
+    if (!method.IsString())
+        throw std::runtime_error("method should be a string");
+
+    Step step;
+    step.method = &RpcMethodRegistry::instance()->find(method.As<Napi::String>().Utf8Value());
+    if (!timeout.IsUndefined())
+    {
+        if (!timeout.IsNumber() || timeout.As<Napi::Number>().DoubleValue() < 0)
+            throw std::runtime_error("timeoutMs should be a positive number");
+        step.timeoutMs = timeout.As<Napi::Number>().Uint32Value();
+    }
+
+    bool hasMap = map.IsObject();
+    if (request.IsBuffer())
+    {
+        if (hasMap)
+            throw std::runtime_error("a packed request can't be mapped, pass the request as an object");
+        step.packed = TypeConversion::JsToCpp<fbrpc::sBuffer>::convert(request);
+    }
+    else
+    {
+        step.requestType = step.method->requestSchema();
+        if (request.IsUndefined() || request.IsNull())
+            step.request.kind = DynamicValue::Kind::kObject;
+        else
+            step.request = ObjectEncoder::fromJs(step.requestType, request);
+    }
+
+    if (!hasMap)
+        return step;
+
+    if (!previous)
+        throw std::runtime_error("the first step has no response to map from");
+
+    if (!previous->responseType.object)
+        previous->responseType = previous->method->responseSchema();
+
+    // validate both sides now, so a bad path fails the call instead of a half executed chain
+    auto mapObj = map.As<Napi::Object>();
+    auto keys = mapObj.GetPropertyNames();
+    for (uint32_t i = 0; i < keys.Length(); ++i)
+    {
+        Napi::Value key = keys.Get(i);
+        Napi::Value from = mapObj.Get(key);
+        if (!from.IsString())
+            throw std::runtime_error("map values should be response field paths");
+
+        Mapping mapping{
+            ObjectEncoder::resolvePath(previous->responseType, SchemaRegistry::splitPath(from.As<Napi::String>().Utf8Value())),
+            SchemaRegistry::splitPath(key.As<Napi::String>().Utf8Value())
+        };
+
+        auto fromField = mapping.from.fields.back();
+        auto toField = ObjectEncoder::findPath(step.requestType, mapping.to);
+        if ((fromField->type()->base_type() == reflection::String) != (toField->type()->base_type() == reflection::String))
+            throw std::runtime_error(fmt::format("can't map {} to {}", fromField->name()->str(), toField->name()->str()));
+
+        step.mappings.push_back(std::move(mapping));
+    }
+    return step;
+}
+
+void RpcPipeline::next(size_t index, const fbrpc::sBuffer* previous)
+{
+    auto& step = m_steps[index];
+    try
+    {
+        auto request = makeRequest(index, previous);
+        auto call = [self = shared_from_this(), index, method = step.method, timeoutMs = step.timeoutMs, request = std::move(request)](ConcurrencyLimiter::Done done) mutable
+        {
+            auto attempt = std::make_shared<Attempt>();
+            attempt->done = std::move(done);
+            if (timeoutMs)
+            {
+                // a lost response would otherwise hold the promise and the limiter slot forever
+                attempt->deadline = Deadlines::instance()->schedule(std::chrono::milliseconds(timeoutMs), [self, index, timeoutMs, attempt]
+                    {
+                        if (attempt->settle(false))
+                            self->m_resolver->fail(fmt::format("pipeline step {} ({}) : no response within {} ms", index, self->m_steps[index].method->name, timeoutMs), kTimeoutCode);
+                    }
+                );
+            }
+
+            try
+            {
+                self->send(index, method, std::move(request), attempt);
+            }
+            catch (...)
+            {
+                // failed by its deadline meanwhile : already reported
+                if (attempt->abandon())
+                    throw;
+            }
+        };
+        auto reject = [self = shared_from_this(), index](const std::string& error)
+        {
+            self->m_resolver->fail(fmt::format("pipeline step {} ({}) : {}", index, self->m_steps[index].method->name, error));
+        };
+        ConcurrencyLimiter::instance()->submit(std::move(call), std::move(reject));
+    }
+    catch (const CodedError& e)
+    {
+        m_resolver->fail(fmt::format("pipeline step {} ({}) : {}", index, step.method->name, e.what()), e.code());
+    }
+    catch (const std::exception& e)
+    {
+        m_resolver->fail(fmt::format("pipeline step {} ({}) : {}", index, step.method->name, e.what()));
+    }
+}
+
+void RpcPipeline::send(size_t index, const RpcMethod* method, fbrpc::sBuffer request, std::shared_ptr<Attempt> attempt)
+{
+    auto self = shared_from_this();
+    auto onResponse = [self, index, attempt](fbrpc::sBuffer response)
+    {
+        if (attempt->settle(true))
+            self->onResponse(index, std::move(response));
+    };
+
+    // routed on the plain request, the shard key may not be readable once compressed. survives reconnects,
+    // see ConnectionManager
+    auto connection = ShardedClient::instance()->route(*method, request);
+    TrafficCapture::instance()->record(TrafficCapture::Kind::kRequest, method->name, request);
+    connection->call(*method, PayloadCodec::instance()->outbound(std::move(request)), std::move(onResponse),
+        [self, index, attempt](const std::string& error, const char* code)
+        {
+            if (attempt->settle(false))
+                self->m_resolver->fail(fmt::format("pipeline step {} ({}) : {}", index, self->m_steps[index].method->name, error), code);
+        }
+    );
+}
+
+bool RpcPipeline::Attempt::settle(bool succeeded)
+{
+    if (settled.exchange(true))
+        return false;
+    Deadlines::instance()->cancel(deadline);
+    done(succeeded);
+    return true;
+}
+
+bool RpcPipeline::Attempt::abandon()
+{
+    if (settled.exchange(true))
+        return false;
+    Deadlines::instance()->cancel(deadline);
+    return true;
+}
+
+void RpcPipeline::onResponse(size_t index, fbrpc::sBuffer response)
+{
+    try
+    {
+        response = PayloadCodec::instance()->inbound(std::move(response));
+    }
+    catch (const std::exception& e)
+    {
+        m_resolver->fail(fmt::format("pipeline step {} : {}", index, e.what()));
+        return;
+    }
+
+    TrafficCapture::instance()->record(TrafficCapture::Kind::kResponse, m_steps[index].method->name, response);
+    if (index + 1 == m_steps.size())
+        m_resolver->call(std::move(response));
+    else
+        next(index + 1, &response);
+}
+
+fbrpc::sBuffer RpcPipeline::makeRequest(size_t index, const fbrpc::sBuffer* previous)
+{
+    auto& step = m_steps[index];
+    if (step.packed)
+        return std::move(*step.packed);
+
+    for (auto& mapping : step.mappings)
+    {
+        auto data = reinterpret_cast<const uint8_t*>(previous->data.get());
+        step.request.set(mapping.to, ObjectEncoder::readField(mapping.from, data, previous->length));
+    }
+
+    m_builder.Clear();
+    ObjectEncoder::build(m_builder, step.requestType, step.request);
+    return fbrpc::sBuffer::clone(reinterpret_cast<char*>(m_builder.GetBufferPointer()), m_builder.GetSize());
+}
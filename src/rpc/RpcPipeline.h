@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <optional>
+
+#include <napi.h>
+#include <flatbuffers/flatbuffers.h>
+
+#include "FlatBufferBinding.h"
+#include "common/reflection/DynamicValue.h"
+#include "common/reflection/ObjectEncoder.h"
+#include "RpcMethod.h"
+#include "ConcurrencyLimiter.h"
+
+//
+// dependent call chains executed natively :
+//
+//   Pipeline.run([
+//       { method : 'ServiceA.call', request : { id : 42 } },
+//       { method : 'ServiceB.call', request : { limit : 10 }, map : { 'filter.y' : 'x' } },
+//   ])
+//
+// every step is dispatched from the response callback of the previous one, `map` copies scalar / string
+// fields of the previous response into the request (schema field paths), only the last response goes back to js.
+// a step not answered within its `timeoutMs` (kDefaultTimeoutMs) fails the chain with kTimeoutCode
+//
+class RpcPipeline : public std::enable_shared_from_this<RpcPipeline>
+{
+public:
+    static constexpr const char* kTimeoutCode = "ERR_RPC_TIMEOUT";
+    static constexpr uint32_t kDefaultTimeoutMs = 30000;
+
+    static Napi::Value run(Napi::Value steps);
+
+private:
+    struct Mapping
+    {
+        ObjectEncoder::FieldPath from;  // field path in the previous response
+        std::vector<std::string> to;    // field path in the request
+    };
+
+    struct Step
+    {
+        const RpcMethod* method = nullptr;
+        SchemaRegistry::Type requestType;
+        SchemaRegistry::Type responseType;
+        DynamicValue request;
+        std::optional<fbrpc::sBuffer> packed;
+        std::vector<Mapping> mappings;
+        uint32_t timeoutMs = kDefaultTimeoutMs; // 0 waits forever
+    };
+
+    // a started step, settled by the first of its response, its failure and its deadline
+    struct Attempt
+    {
+        ConcurrencyLimiter::Done done;
+        std::atomic<uint64_t> deadline{ 0 };
+        std::atomic<bool> settled{ false };
+
+        // false when already settled, the caller then drops what it got
+        bool settle(bool succeeded);
+        // the step threw before going out, its limiter slot is then freed by the limiter itself. false when
+        // already settled (by the deadline)
+        bool abandon();
+    };
+
+    static Step parseStep(const Napi::Value& value, Step* previous);
+
+    void next(size_t index, const fbrpc::sBuffer* previous);
+    void send(size_t index, const RpcMethod* method, fbrpc::sBuffer request, std::shared_ptr<Attempt> attempt);
+    void onResponse(size_t index, fbrpc::sBuffer response);
+    fbrpc::sBuffer makeRequest(size_t index, const fbrpc::sBuffer* previous);
+
+    std::vector<Step> m_steps;
+    std::shared_ptr<Resolver<fbrpc::sBuffer>> m_resolver;
+    flatbuffers::FlatBufferBuilder m_builder;
+};
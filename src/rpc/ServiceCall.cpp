@@ -0,0 +1,155 @@
+#include <utility>
+
+#include "common/node/Node.h"
+#include "FlatBufferBinding.h"
+#include "ConnectionManager.h"
+#include "ShardedClient.h"
+#include "ConcurrencyLimiter.h"
+#include "PayloadCodec.h"
+#include "TrafficCapture.h"
+#include "ServiceCall.h"
+
+BindingHelper::Callable ServiceCall::bind(const std::string& name, BindingHelper::Callback callback)
+{
+    // lives as long as the addon, like the registry entry of its method
+    auto binding = new Binding{ name, callback };
+
+    RpcMethod method;
+    method.name = name;
+    method.dispatch = [id = name](std::shared_ptr<fbrpc::sFlatBufferRpcClient> client, fbrpc::sBuffer request,
+        RpcMethod::ResponseHandler onResponse, RpcMethod::FailureHandler)
+    {
+        RpcMethod::send(*client, id, std::move(request), std::move(onResponse));
+    };
+
+    auto registry = RpcMethodRegistry::instance();
+    registry->add(std::move(method));
+    binding->method = &registry->find(name);
+
+    return [binding](const Napi::CallbackInfo& info)
+    {
+        return invoke(*binding, info);
+    };
+}
+
+Napi::Value ServiceCall::invoke(Binding& binding, const Napi::CallbackInfo& info)
+{
+    Context context;
+    context.binding = &binding;
+    for (size_t i = 0; i < info.Length(); ++i)
+    {
+        if (EventCallback<fbrpc::sBuffer>::check(info[i]))
+            context.mode = Mode::kDirect;
+    }
+
+    Scope scope(&context);
+    try
+    {
+        return binding.callback(info);
+    }
+    catch (const Deferred&)
+    {
+        return context.result;
+    }
+}
+
+void ServiceCall::journal(Context& context)
+{
+    auto& binding = *context.binding;
+    auto promise = Napi::Promise::Deferred::New(Node::getEnv());
+    context.result = promise.Promise();
+    auto resolver = std::make_shared<Resolver<fbrpc::sBuffer>>(promise);
+
+    auto request = std::move(*context.request);
+    context.request.reset();
+    // started right away when the limiter has room, else once a call completes
+    auto call = [method = binding.method, connection = context.connection, resolver, request = std::move(request)](ConcurrencyLimiter::Done done) mutable
+    {
+        try
+        {
+            connection->call(*method, std::move(request),
+                [method, resolver, done](fbrpc::sBuffer response)
+                {
+                    done(true);
+                    // unwrapped here like the events, js gets the plain flatbuffer
+                    try
+                    {
+                        response = PayloadCodec::instance()->inbound(std::move(response));
+                    }
+                    catch (const std::exception& e)
+                    {
+                        resolver->fail(e.what());
+                        return;
+                    }
+                    TrafficCapture::instance()->record(TrafficCapture::Kind::kResponse, method->name, response);
+                    resolver->call(std::move(response));
+                },
+                [resolver, done](const std::string& error, const char* code)
+                {
+                    done(false);
+                    resolver->fail(error, code);
+                }
+            );
+        }
+        catch (const CodedError& e)
+        {
+            done(false);
+            resolver->fail(e.what(), e.code());
+        }
+    };
+    auto reject = [resolver](const std::string& error)
+    {
+        resolver->fail(error);
+    };
+
+    try
+    {
+        ConcurrencyLimiter::instance()->submit(std::move(call), std::move(reject));
+    }
+    catch (const CodedError& e)
+    {
+        resolver->fail(e.what(), e.code());
+    }
+    catch (const std::exception& e)
+    {
+        resolver->fail(e.what());
+    }
+
+    // sent by the journal, the binding must not send
+    throw Deferred();
+}
+
+std::shared_ptr<fbrpc::sFlatBufferRpcClient> ServiceCall::client()
+{
+    if (!m_current)
+        return nullptr;
+
+    // nothing packed : the binding sends on the connected client itself, unjournaled
+    auto& context = *m_current;
+    if (context.mode == Mode::kPacking && context.request)
+        journal(context);
+    if (!context.client)
+        context.client = ConnectionManager::instance()->client();
+    return context.client;
+}
+
+bool ServiceCall::packing()
+{
+    return m_current && m_current->mode == Mode::kPacking && !m_current->request;
+}
+
+fbrpc::sBuffer ServiceCall::pack(fbrpc::sBuffer request)
+{
+    // captured and routed plain, once per js call
+    bool packing = ServiceCall::packing();
+    if (packing)
+    {
+        TrafficCapture::instance()->record(TrafficCapture::Kind::kRequest, m_current->binding->name, request);
+        m_current->connection = ShardedClient::instance()->route(*m_current->binding->method, request);
+    }
+    auto outbound = PayloadCodec::instance()->outbound(std::move(request));
+    // kept for the journal
+    if (packing)
+        m_current->request = outbound;
+    return outbound;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <optional>
+
+#include <napi.h>
+
+#include "fbrpc/ssFlatBufferRpc.h"
+#include "common/binding/BindingHelper.h"
+#include "RpcMethod.h"
+
+class ConnectionManager;
+
+//
+// the generated service functions as journaled RpcMethods : main.cpp binds FlatBufferBinding::bind through bind(),
+// which registers every function by its "Service.method" name and wraps what js calls.
+//
+// a method is dispatched natively, as a raw fbrpc call of its id (see RpcMethod::send) : native callers (Pipeline,
+// ConnectionManager, Sharding) send already packed requests from any thread, without running js.
+//
+// a js call runs the binding until it asks FlatbufferClient::get() for a client : its request (the Buffer packed by
+// the ts wrapper, or a Packed<T>) then goes to ConnectionManager::call, on the shard ShardedClient routes it to.
+// js gets the journal's promise instead of the binding's own, the binding is unwound without sending. functions
+// taking an event callback are not calls, they run as bound, like a call that packed no request
+//
+class ServiceCall
+{
+public:
+    // BindingHelper::Interceptor of the generated bindings
+    static BindingHelper::Callable bind(const std::string& name, BindingHelper::Callback callback);
+
+    // js thread, what the running binding sends on : the connected client, nothing outside of a binding.
+    // a js call with a request is journaled instead and never gets one
+    static std::shared_ptr<fbrpc::sFlatBufferRpcClient> client();
+    // whether the running binding is a js call without a request yet : the next one converted is its request
+    static bool packing();
+    // the wire form (see PayloadCodec) of a request packed by the running binding
+    static fbrpc::sBuffer pack(fbrpc::sBuffer request);
+
+private:
+    enum class Mode
+    {
+        kPacking,   // js call, until its request is journaled
+        kDirect     // js call run as bound
+    };
+
+    struct Binding
+    {
+        std::string name;
+        BindingHelper::Callback callback;
+        const RpcMethod* method = nullptr;
+    };
+
+    struct Context
+    {
+        Mode mode = Mode::kPacking;
+        Binding* binding = nullptr;
+        std::shared_ptr<fbrpc::sFlatBufferRpcClient> client;
+        std::optional<fbrpc::sBuffer> request;
+        // where the request is journaled, routed while it is still plain
+        std::shared_ptr<ConnectionManager> connection;
+        // the journal's promise
+        Napi::Value result;
+    };
+
+    // thrown through the binding of a js call once journaled
+    struct Deferred {};
+
+    class Scope
+    {
+    public:
+        Scope(Context* context) : m_previous(std::exchange(m_current, context)) {}
+        ~Scope() { m_current = m_previous; }
+    private:
+        Context* m_previous;
+    };
+
+    static Napi::Value invoke(Binding& binding, const Napi::CallbackInfo& info);
+    [[noreturn]] static void journal(Context& context);
+
+    inline static thread_local Context* m_current = nullptr;
+};
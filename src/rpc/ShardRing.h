@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <string_view>
+
+//
+// consistent hash ring : every shard owns kVirtualNodes points placed by hashing its identity (address:port),
+// a key goes to the first point at or after its hash. points only depend on the identity, never on the shard
+// order, so adding or removing one of N shards only remaps the ~1/N keys it gains or owned
+//
+class ShardRing
+{
+public:
+    static constexpr uint32_t kVirtualNodes = 160;
+
+    explicit ShardRing(const std::vector<std::string>& identities)
+    {
+        m_points.reserve(identities.size() * kVirtualNodes);
+        for (uint32_t shard = 0; shard < identities.size(); ++shard)
+        {
+            for (uint32_t node = 0; node < kVirtualNodes; ++node)
+                m_points.emplace_back(hash(identities[shard] + "#" + std::to_string(node)), shard);
+        }
+        std::sort(m_points.begin(), m_points.end());
+    }
+
+    uint32_t find(std::string_view key) const
+    {
+        auto it = std::lower_bound(m_points.begin(), m_points.end(), std::make_pair(hash(key), uint32_t(0)));
+        return it == m_points.end() ? m_points.front().second : it->second;
+    }
+
+    bool empty() const
+    {
+        return m_points.empty();
+    }
+
+    // fnv-1a with a splitmix finalizer, stable across runs and platforms unlike std::hash
+    static uint64_t hash(std::string_view data)
+    {
+        uint64_t value = 14695981039346656037ull;
+        for (auto c : data)
+        {
+            value ^= static_cast<uint8_t>(c);
+            value *= 1099511628211ull;
+        }
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ull;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebull;
+        value ^= value >> 31;
+        return value;
+    }
+
+private:
+    std::vector<std::pair<uint64_t, uint32_t>> m_points;
+};
@@ -0,0 +1,117 @@
+#include <atomic>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "common/node/Node.h"
+#include "common/reflection/ObjectEncoder.h"
+#include "ShardedClient.h"
+
+namespace
+{
+    std::string keyOf(const DynamicValue& value)
+    {
+        switch (value.kind)
+        {
+        case DynamicValue::Kind::kString:
+            return value.string;
+        case DynamicValue::Kind::kBool:
+        case DynamicValue::Kind::kInteger:
+            return std::to_string(value.integer);
+        case DynamicValue::Kind::kReal:
+            return fmt::format("{}", value.real);
+        default:
+            return {};
+        }
+    }
+
+    // settles the connect promise once : on the first failed attempt, or when every shard is connected
+    struct Connection
+    {
+        std::shared_ptr<Resolver<Result>> resolver;
+        std::atomic<size_t> pending;
+        std::atomic<bool> settled{ false };
+
+        void settle(Result result)
+        {
+            if (!settled.exchange(true))
+                resolver->call(std::move(result));
+        }
+    };
+}
+
+Napi::Value ShardedClient::connect(Option option)
+{
+    if (option.endpoints.empty())
+        throw std::runtime_error("sharding expects at least one endpoint");
+
+    auto state = std::make_shared<State>();
+    for (auto& key : option.keys)
+    {
+        auto& method = RpcMethodRegistry::instance()->find(key.method);
+        state->keys[key.method] = ObjectEncoder::resolvePath(method.requestSchema(), SchemaRegistry::splitPath(key.field));
+    }
+
+    std::vector<std::string> identities;
+    for (auto& endpoint : option.endpoints)
+        identities.push_back(fmt::format("{}:{}", endpoint.address, endpoint.port));
+    state->ring = std::make_unique<ShardRing>(identities);
+
+    auto promise = Napi::Promise::Deferred::New(Node::getEnv());
+    auto connection = std::make_shared<Connection>();
+    connection->resolver = std::make_shared<Resolver<Result>>(promise);
+    connection->pending = option.endpoints.size();
+
+    // a shard is one server, its keys hash to it
+    auto shardOption = ConnectionManager::instance()->option();
+    shardOption.fallbacks.clear();
+
+    for (size_t i = 0; i < option.endpoints.size(); ++i)
+    {
+        // never destroyed from a network thread, it may be one of its client's own
+        std::shared_ptr<ConnectionManager> shard(new ConnectionManager(shardOption),
+            [](ConnectionManager* shard)
+            {
+                Node::runOnJsThread([shard](Napi::Env) { delete shard; });
+            }
+        );
+        shard->connect(std::move(option.endpoints[i]), [connection, identity = identities[i]](bool connected, const std::string& message)
+            {
+                if (!connected)
+                    connection->settle(Result{ false, fmt::format("{} : {}", identity, message) });
+                else if (--connection->pending == 0)
+                    connection->settle(Result{ true });
+            }
+        );
+        state->shards.push_back(std::move(shard));
+    }
+
+    std::atomic_store(&instance()->m_state, std::shared_ptr<const State>(std::move(state)));
+    return promise.Promise();
+}
+
+uint32_t ShardedClient::shardOf(std::string key)
+{
+    auto state = std::atomic_load(&instance()->m_state);
+    if (!state)
+        throw std::runtime_error("sharding is not configured");
+    return state->ring->find(key);
+}
+
+std::shared_ptr<ConnectionManager> ShardedClient::route(const RpcMethod& method, const fbrpc::sBuffer& request) const
+{
+    auto state = std::atomic_load(&m_state);
+    if (!state)
+        return std::shared_ptr<ConnectionManager>(std::shared_ptr<void>(), ConnectionManager::instance());
+
+    uint32_t shard = 0;
+    auto it = state->keys.find(method.name);
+    if (it != state->keys.end())
+    {
+        auto data = reinterpret_cast<const uint8_t*>(request.data.get());
+        shard = state->ring->find(keyOf(ObjectEncoder::readField(it->second, data, request.length)));
+    }
+
+    // a shard reconnecting queues the call, see ConnectionManager::call
+    return state->shards[shard];
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <napi.h>
+
+#include "FlatBufferBinding.h"
+#include "common/reflection/ObjectEncoder.h"
+#include "RpcMethod.h"
+#include "ConnectionManager.h"
+#include "ShardRing.h"
+
+//
+// several identical servers behind one client : Sharding.connect({ endpoints, keys }) connects every endpoint,
+// calls of a method listed in `keys` are then routed by the value of a request field (schema field path)
+// through a consistent hash ring, so a key always reaches the same shard. other methods go to the first one.
+// each shard is a ConnectionManager of its own (with the Reconnect.configure options but no fallbacks) : a
+// dropped shard is reconnected and its journaled calls replayed or failed, like the single connection's
+//
+class ShardedClient : public Singleton<ShardedClient>
+{
+public:
+    struct ShardKey
+    {
+        std::string method; // Service.method
+        std::string field;  // request field path, eg : 'user.id'
+    };
+
+    struct Option
+    {
+        std::vector<fbrpc::sTCPOption> endpoints;
+        std::vector<ShardKey> keys;
+    };
+
+    static Napi::Value connect(Option option);
+
+    // shard index of a key, to check the routing from js
+    static uint32_t shardOf(std::string key);
+
+    // the connection `request` (not compressed yet) of `method` goes to, ConnectionManager::instance() until
+    // Sharding.connect. holding the result keeps the shard alive through a later Sharding.connect, the last
+    // holder of a replaced shard hands its release over to the js thread
+    std::shared_ptr<ConnectionManager> route(const RpcMethod& method, const fbrpc::sBuffer& request) const;
+
+private:
+    struct State
+    {
+        std::vector<std::shared_ptr<ConnectionManager>> shards;
+        std::unique_ptr<ShardRing> ring;
+        std::unordered_map<std::string, ObjectEncoder::FieldPath> keys; // method => shard key
+    };
+
+    // replaced as a whole on connect, read without locking from the network threads
+    std::shared_ptr<const State> m_state;
+};
+
+namespace PODTypeBinding
+{
+    template <>
+    struct Bind<ShardedClient::ShardKey>
+    {
+        static constexpr auto Binder = makeBinder(
+            "method", &ShardedClient::ShardKey::method,
+            "field", &ShardedClient::ShardKey::field
+        );
+    };
+
+    template <>
+    struct Bind<ShardedClient::Option>
+    {
+        static constexpr auto Binder = makeBinder(
+            "endpoints", &ShardedClient::Option::endpoints,
+            "keys", &ShardedClient::Option::keys
+        );
+    };
+}
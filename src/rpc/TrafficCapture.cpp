@@ -0,0 +1,209 @@
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <filesystem>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "common/node/Node.h"
+#include "FlatBufferBinding.h"
+#include "TrafficCapture.h"
+
+namespace
+{
+    uint64_t now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    constexpr uint64_t align8(uint64_t size)
+    {
+        return (size + 7) & ~uint64_t(7);
+    }
+}
+
+TrafficCapture::MappedLog::MappedLog(const std::string& path, size_t capacity)
+    : m_capacity(capacity), m_start(now())
+{
+    m_file = CreateFileW(std::filesystem::u8path(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+        nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error(fmt::format("can't create capture file {} (error {})", path, GetLastError()));
+
+    // the mapping extends the file to its capacity, pages are only committed once written
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(uint64_t(capacity) >> 32), static_cast<DWORD>(capacity & 0xFFFFFFFF), nullptr);
+    if (m_mapping)
+        m_view = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, capacity));
+    if (!m_view)
+    {
+        auto error = GetLastError();
+        close();
+        throw std::runtime_error(fmt::format("can't map capture file {} (error {})", path, error));
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    std::memcpy(m_view, &header, sizeof(header));
+}
+
+TrafficCapture::MappedLog::~MappedLog()
+{
+    close();
+}
+
+void TrafficCapture::MappedLog::append(Kind kind, uint32_t method, const void* payload, size_t length)
+{
+    if (!guard.enter())
+        return;
+
+    auto size = align8(sizeof(Record) + length);
+    auto offset = tail.fetch_add(size, std::memory_order_relaxed);
+    if (offset + size > m_capacity)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        guard.leave();
+        return;
+    }
+
+    Record record{};
+    record.size = static_cast<uint32_t>(size);
+    record.kind = kind;
+    record.timestamp = now() - m_start;
+    record.method = method;
+    record.length = static_cast<uint32_t>(length);
+    std::memcpy(m_view + offset, &record, sizeof(record));
+    std::memcpy(m_view + offset + sizeof(record), payload, length);
+    records.fetch_add(1, std::memory_order_relaxed);
+    guard.leave();
+}
+
+void TrafficCapture::MappedLog::close()
+{
+    guard.close();
+    if (m_view)
+    {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+    }
+    if (m_mapping)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        // drop the unused end of the reservation, a record cut by a full log is followed by zeros anyway
+        LARGE_INTEGER size;
+        size.QuadPart = static_cast<LONGLONG>(std::min<uint64_t>(tail.load(), m_capacity));
+        SetFilePointerEx(m_file, size, nullptr, FILE_BEGIN);
+        SetEndOfFile(m_file);
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+}
+
+uint32_t TrafficCapture::methodId(MappedLog& log, const std::string& method)
+{
+    if (method.empty())
+        return 0;
+
+    std::lock_guard<std::mutex> lock(log.methodMutex);
+    auto it = log.methods.find(method);
+    if (it != log.methods.end())
+        return it->second;
+
+    auto id = static_cast<uint32_t>(log.methods.size() + 1);
+    log.methods.emplace(method, id);
+    log.append(Kind::kMethod, id, method.data(), method.size());
+    return id;
+}
+
+void TrafficCapture::start(Option option)
+{
+    if (option.capacityMB == 0)
+        throw std::runtime_error("capture capacity should not be 0");
+
+    auto capture = instance();
+    std::lock_guard<std::mutex> lock(capture->m_mutex);
+    if (capture->m_log.load())
+        throw std::runtime_error("a capture is already running");
+
+    auto log = std::make_unique<MappedLog>(option.path, size_t(option.capacityMB) << 20);
+    capture->m_log = log.get();
+    capture->m_logs.push_back(std::move(log));
+}
+
+Napi::Value TrafficCapture::stop()
+{
+    Napi::Env env = Node::getEnv();
+    auto capture = instance();
+    std::lock_guard<std::mutex> lock(capture->m_mutex);
+    auto log = capture->m_log.exchange(nullptr);
+    if (!log)
+        throw std::runtime_error("no capture is running");
+
+    log->close();
+    auto result = Napi::Object::New(env);
+    result.Set("records", static_cast<double>(log->records.load()));
+    result.Set("dropped", static_cast<double>(log->dropped.load()));
+    result.Set("methods", static_cast<double>(log->methods.size()));
+    return result;
+}
+
+Napi::Value TrafficCapture::replay(std::string path, double speed, ReplayCallback callback)
+{
+    std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+    if (!file)
+        throw std::runtime_error(fmt::format("can't open capture file {}", path));
+
+    auto data = std::make_shared<std::vector<char>>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    FileHeader header{};
+    if (data->size() < sizeof(header))
+        throw std::runtime_error("not a capture file");
+    std::memcpy(&header, data->data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion)
+        throw std::runtime_error("not a capture file, or from another version");
+
+    auto promise = Napi::Promise::Deferred::New(Node::getEnv());
+    auto resolver = std::make_shared<Resolver<uint64_t>>(promise);
+    std::thread([data, speed, callback, resolver]
+        {
+            std::unordered_map<uint32_t, std::string> methods;
+            auto begin = std::chrono::steady_clock::now();
+            uint64_t played = 0;
+            size_t offset = sizeof(FileHeader);
+            while (offset + sizeof(Record) <= data->size())
+            {
+                Record record{};
+                std::memcpy(&record, data->data() + offset, sizeof(record));
+                if (record.size == 0 || offset + record.size > data->size())
+                    break;
+
+                auto payload = data->data() + offset + sizeof(record);
+                offset += record.size;
+                if (record.kind == Kind::kMethod)
+                {
+                    methods[record.method].assign(payload, record.length);
+                    continue;
+                }
+
+                if (speed > 0)
+                    std::this_thread::sleep_until(begin + std::chrono::nanoseconds(static_cast<int64_t>(record.timestamp / speed)));
+
+                auto it = methods.find(record.method);
+                callback(static_cast<uint32_t>(record.kind), it == methods.end() ? std::string() : it->second,
+                    fbrpc::sBuffer::clone(payload, record.length));
+                ++played;
+            }
+            resolver->call(std::move(played));
+        }
+    ).detach();
+    return promise.Promise();
+}
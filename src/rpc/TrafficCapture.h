@@ -0,0 +1,112 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#include <windows.h>
+#include <napi.h>
+
+#include "fbrpc/ssFlatBufferRpc.h"
+#include "common/utils/Singleton.h"
+#include "common/utils/UseGuard.h"
+
+//
+// traffic capture into a memory mapped log, for offline replay (Capture.replay, replay.ts). the file is
+//
+//   [FileHeader][Record][payload][pad to 8][Record]...
+//
+// writers reserve their record with one atomic add on the tail and copy into the mapping, so capturing costs a
+// memcpy per message. method names are interned : the first use of a name writes a kMethod record carrying it
+// and later records only keep its id. a full log drops records (counted) instead of growing
+//
+class TrafficCapture : public Singleton<TrafficCapture>
+{
+public:
+    enum class Kind : uint8_t
+    {
+        kMethod,
+        kRequest,
+        kResponse,
+        kEvent
+    };
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+    };
+
+    struct Record
+    {
+        uint32_t size;      // whole record, padded to 8, 0 ends the log
+        Kind kind;
+        uint8_t reserved[3];
+        uint64_t timestamp; // nanoseconds since the capture started
+        uint32_t method;    // interned name id, 0 when unknown (eg : events)
+        uint32_t length;    // payload bytes
+    };
+
+    struct Option
+    {
+        std::string path;
+        uint32_t capacityMB = 256;
+    };
+
+    static constexpr char kMagic[8] = { 'F', 'B', 'R', 'P', 'C', 'C', 'A', 'P' };
+    static constexpr uint32_t kVersion = 1;
+
+    using ReplayCallback = std::function<void(uint32_t kind, std::string method, fbrpc::sBuffer payload)>;
+
+    static void start(Option option);
+    static Napi::Value stop();
+
+    // plays a capture back on a native thread, at its original pace divided by `speed` (0 : as fast as possible),
+    // resolves with the number of records played once the last one has been queued to `callback`
+    static Napi::Value replay(std::string path, double speed, ReplayCallback callback);
+
+    // any thread, a no-op unless capturing
+    void record(Kind kind, const std::string& method, const fbrpc::sBuffer& payload)
+    {
+        if (auto log = m_log.load(std::memory_order_acquire))
+            log->append(kind, methodId(*log, method), payload.data.get(), payload.length);
+    }
+
+private:
+    class MappedLog
+    {
+    public:
+        MappedLog(const std::string& path, size_t capacity);
+        ~MappedLog();
+
+        void append(Kind kind, uint32_t method, const void* payload, size_t length);
+        void close();
+
+        UseGuard guard;
+        std::mutex methodMutex;
+        std::unordered_map<std::string, uint32_t> methods;
+        std::atomic<uint64_t> tail{ sizeof(FileHeader) };
+        std::atomic<uint64_t> records{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+
+    private:
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+        uint8_t* m_view = nullptr;
+        size_t m_capacity = 0;
+        uint64_t m_start = 0;
+    };
+
+    uint32_t methodId(MappedLog& log, const std::string& method);
+
+    std::mutex m_mutex;
+    std::atomic<MappedLog*> m_log{ nullptr };
+    // stopped logs stay allocated, a late writer may still hold the pointer (its guard then refuses it)
+    std::vector<std::unique_ptr<MappedLog>> m_logs;
+};
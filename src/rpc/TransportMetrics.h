@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <napi.h>
+
+#include "common/node/Node.h"
+#include "common/utils/Singleton.h"
+
+//
+// connection level counters and gauges, updated with relaxed atomics from the network threads and read by js
+// in one snapshot (metrics() next to connect()). covers the calls journaled by ConnectionManager, the sharded
+// pipeline calls and the events, rtt is smoothed like tcp's srtt (1/8 of each new sample)
+//
+class TransportMetrics : public Singleton<TransportMetrics>
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr double kRttGain = 1.0 / 8;
+
+    std::atomic<uint64_t> bytesSent{ 0 };
+    std::atomic<uint64_t> messagesSent{ 0 };
+    std::atomic<uint64_t> bytesReceived{ 0 };
+    std::atomic<uint64_t> messagesReceived{ 0 };
+    // calls waiting for a connection
+    std::atomic<int64_t> queued{ 0 };
+    // calls sent and not answered yet
+    std::atomic<int64_t> inflight{ 0 };
+    std::atomic<uint64_t> reconnects{ 0 };
+
+    void sent(size_t bytes)
+    {
+        bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+        messagesSent.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void received(size_t bytes)
+    {
+        bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+        messagesReceived.fetch_add(1, std::memory_order_relaxed);
+        m_lastReceive.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    void sampleRtt(Clock::time_point sentAt)
+    {
+        double sample = std::chrono::duration<double, std::milli>(Clock::now() - sentAt).count();
+        double srtt = m_srtt.load(std::memory_order_relaxed);
+        double next;
+        do
+        {
+            next = srtt == 0 ? sample : srtt + kRttGain * (sample - srtt);
+        } while (!m_srtt.compare_exchange_weak(srtt, next, std::memory_order_relaxed));
+    }
+
+    static Napi::Value snapshot()
+    {
+        auto metrics = instance();
+        auto lastReceive = metrics->m_lastReceive.load(std::memory_order_relaxed);
+        double sinceReceive = lastReceive == 0 ? -1.0
+            : std::chrono::duration<double, std::milli>(Clock::now().time_since_epoch() - Clock::duration(lastReceive)).count();
+
+        auto result = Napi::Object::New(Node::getEnv());
+        result.Set("bytesSent", static_cast<double>(metrics->bytesSent.load(std::memory_order_relaxed)));
+        result.Set("messagesSent", static_cast<double>(metrics->messagesSent.load(std::memory_order_relaxed)));
+        result.Set("bytesReceived", static_cast<double>(metrics->bytesReceived.load(std::memory_order_relaxed)));
+        result.Set("messagesReceived", static_cast<double>(metrics->messagesReceived.load(std::memory_order_relaxed)));
+        result.Set("queued", static_cast<double>(metrics->queued.load(std::memory_order_relaxed)));
+        result.Set("inflight", static_cast<double>(metrics->inflight.load(std::memory_order_relaxed)));
+        result.Set("srttMs", metrics->m_srtt.load(std::memory_order_relaxed));
+        result.Set("reconnects", static_cast<double>(metrics->reconnects.load(std::memory_order_relaxed)));
+        result.Set("sinceReceiveMs", sinceReceive);
+        return result;
+    }
+
+private:
+    std::atomic<double> m_srtt{ 0 };
+    std::atomic<Clock::rep> m_lastReceive{ 0 };
+};